@@ -0,0 +1,90 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Bit-packed per-person attribute column (one bit per person ID).
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVBitColumn_H
+#define CVBitColumn_H
+
+//! c++
+#include <vector>
+#include <cstdint>
+
+//! root
+#include <TRandom.h>
+
+#include "CVCheckpoint.h"
+
+using namespace std;
+
+class CVBitColumn
+{
+  public:
+    CVBitColumn(int size=0) { Resize(size); }
+
+    void Resize(int size) {
+      fSize = size;
+      fWords.assign((size+63)/64,0);
+    }
+    void Clear() { fill(fWords.begin(),fWords.end(),0); }
+
+    //! getters
+    int  GetSize() const     { return fSize; }
+    bool Get(int index) const { return (fWords[index>>6] >> (index&63)) & 1; }
+    int  Count() const {
+      int count = 0;
+      for(auto word : fWords) count += __builtin_popcountll(word);
+      return count;
+    }
+
+    //! setters
+    void Set(int index, bool value=true) {
+      if(value) fWords[index>>6] |=  (uint64_t(1) << (index&63));
+      else      fWords[index>>6] &= ~(uint64_t(1) << (index&63));
+    }
+
+    //! set each bit independently with probability prob. Random numbers are drawn
+    //! one word (64 persons) at a time and packed with a branch-free comparison,
+    //! which the compiler turns into vector compares.
+    void Draw(TRandom* random, float prob) {
+      double uniform[64];
+      for(size_t iword = 0; iword < fWords.size(); iword++) {
+        random->RndmArray(64,uniform);
+        uint64_t word = 0;
+        for(int ibit = 0; ibit < 64; ibit++) word |= uint64_t(uniform[ibit] < prob) << ibit;
+        fWords[iword] = word;
+      }
+      //! .. and clear the padding bits beyond the last person
+      if(fSize%64) fWords.back() &= (uint64_t(1) << (fSize%64)) - 1;
+    }
+
+    //! checkpoint of the column (see CVCheckpoint.h)
+    void Write(CVCheckpointWriter& out) const { out.Write(fSize); out.Write(fWords); }
+    void Read(CVCheckpointReader& in)         { in.Read(fSize);   in.Read(fWords);   }
+
+  private:
+    int              fSize;  //! number of valid bits
+    vector<uint64_t> fWords; //! bit i of word i/64 belongs to person i
+};
+
+#endif
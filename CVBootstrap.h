@@ -0,0 +1,164 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Confidence intervals of the mean and rms of per-run outcomes. Every bootstrap resample
+ * draws the runs with replacement, as the number of times each run is drawn, and all
+ * outcomes are computed from the same draw with plain weighted sums over contiguous arrays,
+ * which the compiler vectorizes. An outcome that only some runs contribute to (e.g. only
+ * runs with an outbreak) has a weight of 0 for the others. The resamples are shared by
+ * several threads; each has its own random stream, so the intervals do not depend on the
+ * number of threads. The values are stored in double precision relative to the mean of all
+ * runs, so the one-pass rms does not lose the spread of large outcomes in the rounding of
+ * their squares. The jackknife errors (leave one run out) are computed in closed form.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVBootstrap_H
+#define CVBootstrap_H
+
+//! c++
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+class CVBootstrap
+{
+  public:
+    //! interval of a statistic: the bootstrap percentiles and the jackknife error
+    struct Interval {
+      float low, high, jackknifeError;
+    };
+
+    CVBootstrap(int nRuns) : fNRuns(nRuns) {}
+
+    //! add an outcome with the value of every run and whether the run contributes to it;
+    //! returns its index
+    int AddOutcome(const vector<float>& values, const vector<float>& contributes) {
+      vector<double> w(fNRuns), wx(fNRuns), wxx(fNRuns);
+      double sw = 0, swx = 0;
+      for(int irun = 0; irun < fNRuns; irun++) {
+        w[irun] = contributes[irun] ? 1 : 0;
+        sw += w[irun]; swx += w[irun]*values[irun];
+      }
+      const double center = sw > 0 ? swx/sw : 0;
+      for(int irun = 0; irun < fNRuns; irun++) {
+        wx[irun]  = w[irun]*(values[irun]-center);
+        wxx[irun] = wx[irun]*(values[irun]-center);
+      }
+      fCenter.push_back(center); fW.push_back(w); fWX.push_back(wx); fWXX.push_back(wxx);
+      return fW.size()-1;
+    }
+    int GetNOutcomes() const { return fW.size(); }
+
+    //! draw nResamples resamples with nThreads threads, intervals at the confidence level ..
+    void Run(int nResamples, double confidence = 0.95, int nThreads = 1, uint64_t seed = 1) {
+      fConfidence = confidence;
+      fMeans.assign(fW.size(), vector<float>(nResamples));
+      fRMSs .assign(fW.size(), vector<float>(nResamples));
+      auto Work = [&](int first) {
+        vector<float> counts(fNRuns);
+        for(int iresample = first; iresample < nResamples; iresample += nThreads) {
+          //! the number of times each run is drawn
+          fill(counts.begin(), counts.end(), 0.f);
+          uint64_t state = seed*0x9e3779b97f4a7c15ULL + iresample;
+          for(int idraw = 0; idraw < fNRuns; idraw++) counts[(Next(state) >> 32)*fNRuns >> 32]++;
+          for(size_t ioutcome = 0; ioutcome < fW.size(); ioutcome++) {
+            const double* w = fW[ioutcome].data(), *wx = fWX[ioutcome].data(), *wxx = fWXX[ioutcome].data();
+            const float* c = counts.data();
+            //! independent partial sums in lanes, so that the sums need no reordering to vectorize
+            double lw[kLanes] = {}, lwx[kLanes] = {}, lwxx[kLanes] = {};
+            int irun = 0;
+            for(; irun + kLanes <= fNRuns; irun += kLanes)
+              for(int ilane = 0; ilane < kLanes; ilane++) {
+                lw[ilane]   += c[irun+ilane]*w[irun+ilane];
+                lwx[ilane]  += c[irun+ilane]*wx[irun+ilane];
+                lwxx[ilane] += c[irun+ilane]*wxx[irun+ilane];
+              }
+            for(; irun < fNRuns; irun++) {
+              lw[0]   += c[irun]*w[irun];
+              lwx[0]  += c[irun]*wx[irun];
+              lwxx[0] += c[irun]*wxx[irun];
+            }
+            double sw = 0, swx = 0, swxx = 0;
+            for(int ilane = 0; ilane < kLanes; ilane++) { sw += lw[ilane]; swx += lwx[ilane]; swxx += lwxx[ilane]; }
+            fMeans[ioutcome][iresample] = sw > 0 ? fCenter[ioutcome] + swx/sw : numeric_limits<float>::quiet_NaN();
+            fRMSs[ioutcome][iresample]  = sw > 0 ? sqrt(max(0.,swxx/sw - swx*swx/sw/sw)) : numeric_limits<float>::quiet_NaN();
+          }
+        }
+      };
+      vector<thread> workers;
+      for(int ithread = 1; ithread < nThreads; ithread++) workers.push_back(thread(Work, ithread));
+      Work(0);
+      for(auto& worker : workers) worker.join();
+    }
+
+    Interval GetMeanInterval(int outcome) const { return GetInterval(fMeans[outcome], Jackknife(outcome, false)); }
+    Interval GetRMSInterval (int outcome) const { return GetInterval(fRMSs[outcome],  Jackknife(outcome, true));  }
+
+  private:
+    static const int kLanes = 4; //! doubles in a 256 bit register
+
+    //! splitmix64
+    static uint64_t Next(uint64_t& state) {
+      uint64_t x = (state += 0x9e3779b97f4a7c15ULL);
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    }
+    //! central interval of the resampled statistics (those defined, i.e. with a contributing run)
+    Interval GetInterval(vector<float> resampled, float jackknifeError) const {
+      resampled.erase(remove_if(resampled.begin(), resampled.end(), [](float x) { return std::isnan(x); }), resampled.end());
+      if(resampled.empty()) return { 0, 0, jackknifeError };
+      sort(resampled.begin(), resampled.end());
+      const double tail = (1-fConfidence)/2;
+      const size_t n = resampled.size();
+      return { resampled[size_t(tail*(n-1))], resampled[size_t(ceil((1-tail)*(n-1)))], jackknifeError };
+    }
+    //! error of the mean or rms from the statistics without each contributing run (the
+    //! center of the values does not change it)
+    float Jackknife(int outcome, bool rms) const {
+      double sw = 0, swx = 0, swxx = 0;
+      for(int irun = 0; irun < fNRuns; irun++) { sw += fW[outcome][irun]; swx += fWX[outcome][irun]; swxx += fWXX[outcome][irun]; }
+      if(sw < 2) return 0;
+      auto Statistic = [rms](double w, double wx, double wxx) { return rms ? sqrt(max(0.,wxx/w - wx*wx/w/w)) : wx/w; };
+      double sum = 0, sum2 = 0;
+      for(int irun = 0; irun < fNRuns; irun++) {
+        if(!fW[outcome][irun]) continue;
+        double s = Statistic(sw-1, swx-fWX[outcome][irun], swxx-fWXX[outcome][irun]);
+        sum += s; sum2 += s*s;
+      }
+      double mean = sum/sw;
+      return sqrt(max(0.,(sw-1)/sw*(sum2 - sw*mean*mean)));
+    }
+
+    int    fNRuns;
+    double fConfidence = 0.95;
+    vector<double>          fCenter;          //! by outcome: mean of the contributing runs
+    vector<vector<double> > fW, fWX, fWXX;    //! by outcome and run: contributes, its value - center, its square
+    vector<vector<float> > fMeans, fRMSs;     //! by outcome and resample
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Binary checkpoint of a run, from which a job continues after it was stopped. Layout, little
+ * endian: a header (magic, version, the job it belongs to, the run and the day it continues
+ * with, and the sizes of the event and summary-only output at that time), then the state of
+ * the run as written by CVMC (see CVSnapshot.h). Vectors are stored with their size and
+ * the per-day status of the persons as runs of equal values, so the size of a checkpoint grows
+ * with the persons the outbreak reached, not with the population times the days. A checkpoint
+ * is written to <file>.tmp and renamed when complete, so a job stopped while writing keeps
+ * the one before.
+ * Does not depend on root, so that the header can be read anywhere.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVCheckpoint_H
+#define CVCheckpoint_H
+
+//! c++
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+using namespace std;
+
+//! on-disk header
+struct CVCheckpointHeader {
+  char     magic[8];      //! "CVCKPT\0\0"
+  uint32_t version;
+  int32_t  run;           //! fileIndex of the run
+  uint64_t job;           //! hash of the input and options of the job, checked on resume
+  int32_t  point;         //! of the parameter sweep
+  int32_t  day;           //! the run continues with this day, -1 if it is finished
+  uint32_t seed;          //! of the run
+  int32_t  reserved0;
+  int64_t  eventOffset;   //! size of the event file, -1 if none
+  int64_t  summaryOffset; //! .. and of the summary-only output
+  uint32_t reserved[2];
+};
+static_assert(sizeof(CVCheckpointHeader) == 64, "checkpoint header must be 64 bytes");
+
+static const char     kCVCheckpointMagic[8] = { 'C','V','C','K','P','T',0,0 };
+static const uint32_t kCVCheckpointVersion  = 1;
+
+class CVCheckpointWriter
+{
+  public:
+    CVCheckpointWriter(string filename, const CVCheckpointHeader& header) : fFilename(filename) {
+      fOutput.open((filename+".tmp").c_str(), ios::binary | ios::trunc);
+      CVCheckpointHeader complete = header;
+      memcpy(complete.magic,kCVCheckpointMagic,8);
+      complete.version = kCVCheckpointVersion;
+      Write(complete);
+    }
+    ~CVCheckpointWriter() { Close(); }
+
+    bool IsOpen() { return fOutput.is_open(); }
+
+    //! plain values ..
+    template<class T> void Write(const T& value) {
+      static_assert(is_trivially_copyable<T>::value, "only plain values are written as they are");
+      fOutput.write((const char*) &value,sizeof(T));
+    }
+    //! .. vectors and strings with their size ..
+    template<class T> void Write(const vector<T>& values) {
+      Write(uint64_t(values.size()));
+      if(!values.empty()) fOutput.write((const char*) &values[0],values.size()*sizeof(T));
+    }
+    template<class A, class B> void Write(const vector<pair<A,B> >& values) {
+      Write(uint64_t(values.size()));
+      for(auto& value : values) { Write(value.first); Write(value.second); }
+    }
+    void Write(const string& value) {
+      Write(uint64_t(value.size()));
+      fOutput.write(value.data(),value.size());
+    }
+    template<class K, class V> void Write(const map<K,V>& values) {
+      Write(uint64_t(values.size()));
+      for(auto& kv : values) { Write(kv.first); Write(kv.second); }
+    }
+    //! .. and long vectors with few changes as runs of equal values
+    template<class T> void WriteRuns(const vector<T>& values) {
+      vector<pair<T,uint32_t> > runs;
+      for(size_t i = 0; i < values.size(); i++) {
+        if(runs.empty() || runs.back().first != values[i]) runs.push_back(make_pair(T(values[i]),0));
+        runs.back().second++;
+      }
+      Write(uint64_t(values.size()));
+      Write(uint64_t(runs.size()));
+      for(auto& run : runs) { Write(run.first); Write(run.second); }
+    }
+
+    //! replace the checkpoint with what was written, false if that failed
+    bool Close() {
+      if(!IsOpen()) return false;
+      bool good = fOutput.good();
+      fOutput.close();
+      string written = fFilename+".tmp";
+      if(good) good = rename(written.c_str(),fFilename.c_str()) == 0;
+      else remove(written.c_str());
+      return good;
+    }
+
+  private:
+    string   fFilename;
+    ofstream fOutput;
+};
+
+class CVCheckpointReader
+{
+  public:
+    CVCheckpointReader(string filename) {
+      fInput.open(filename.c_str(), ios::binary);
+      if(!fInput.is_open()) { fError = "could not open checkpoint " + filename; return; }
+      Read(fHeader);
+      if(!fInput.good() || memcmp(fHeader.magic,kCVCheckpointMagic,8)) fError = filename + " is not a checkpoint";
+      else if(fHeader.version != kCVCheckpointVersion) 
+        fError = filename + " has checkpoint version " + to_string(fHeader.version) + ", expected " + to_string(kCVCheckpointVersion);
+    }
+
+    //! false if the header could not be read or something after it was missing
+    bool   IsGood()   { return fError.empty() && fInput.good(); }
+    string GetError() { return fError.empty() && !fInput.good() ? "checkpoint is truncated" : fError; }
+    const CVCheckpointHeader& GetHeader() { return fHeader; }
+
+    template<class T> void Read(T& value) {
+      static_assert(is_trivially_copyable<T>::value, "only plain values are read as they are");
+      fInput.read((char*) &value,sizeof(T));
+    }
+    template<class T> void Read(vector<T>& values) {
+      values.resize(ReadSize(sizeof(T)));
+      if(!values.empty()) fInput.read((char*) &values[0],values.size()*sizeof(T));
+    }
+    template<class A, class B> void Read(vector<pair<A,B> >& values) {
+      values.resize(ReadSize(sizeof(A)+sizeof(B)));
+      for(auto& value : values) { Read(value.first); Read(value.second); }
+    }
+    void Read(string& value) {
+      value.resize(ReadSize(1));
+      if(!value.empty()) fInput.read(&value[0],value.size());
+    }
+    template<class K, class V> void Read(map<K,V>& values) {
+      values.clear();
+      uint64_t size = ReadSize(sizeof(K)+sizeof(V));
+      for(uint64_t i = 0; i < size; i++) {
+        pair<K,V> kv;
+        Read(kv.first); 
+        Read(kv.second);
+        values.insert(kv);
+    } }
+    //! .. and the runs of equal values into a vector of the size written, e.g. the days of the
+    //! population; fails if the size differs or the runs do not cover exactly that many elements
+    template<class T> void ReadRuns(vector<T>& values) {
+      uint64_t size = 0;
+      Read(size);
+      if(size != values.size()) { fInput.setstate(ios::failbit); return; }
+      uint64_t nruns = ReadSize(sizeof(T)+sizeof(uint32_t));
+      uint64_t i = 0;
+      for(uint64_t irun = 0; irun < nruns && fInput.good(); irun++) {
+        T value;
+        uint32_t length = 0;
+        Read(value); 
+        Read(length);
+        if(!fInput.good() || length > size-i) { fInput.setstate(ios::failbit); return; }
+        for(; length--; i++) values[i] = value;
+      }
+      if(i != size) fInput.setstate(ios::failbit);
+    }
+
+  private:
+    //! a size, 0 if the rest of the file can not hold that many elements of .. bytes
+    uint64_t ReadSize(size_t elementSize) {
+      uint64_t size = 0;
+      Read(size);
+      if(!fInput.good()) return 0;
+      streampos position = fInput.tellg();
+      fInput.seekg(0,ios::end);
+      uint64_t left = fInput.tellg() - position;
+      fInput.seekg(position);
+      if(elementSize && size > left/elementSize) { fInput.setstate(ios::failbit); return 0; }
+      return size;
+    }
+
+    ifstream fInput;
+    CVCheckpointHeader fHeader = {};
+    string fError;
+};
+
+#endif
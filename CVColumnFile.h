@@ -0,0 +1,265 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Columnar binary file of the daily census (the content of PopulationLevelInformation),
+ * readable without root. Layout, all little endian and every block 64 byte aligned:
+ *   header     magic, version, number of columns, alignment
+ *   columns    name, type and width of each column
+ *   batches    per run: run index and number of days, then each column as a contiguous array
+ *   index      per run: run index, number of days and file offset of its batch
+ *   trailer    offset of the index, number of runs, magic
+ * A reader maps the file, finds the runs through the trailer and index, and uses the column
+ * arrays in place. The aligned fixed-width buffers follow the Arrow memory layout, so they can
+ * be wrapped in Arrow arrays without copying (see CVColumns.py).
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVColumnFile_H
+#define CVColumnFile_H
+
+//! c++
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+//! posix
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+//! one entry of the daily census, as in the PopulationLevelInformation tree
+struct CVDayRecord {
+  int   fileIndex;
+  int   day;
+  int   nSusceptible;
+  int   nExposed;
+  int   nInfectious;
+  int   nRecovered;
+  int   nTraced;
+  int   nReported;
+  float effectiveR;
+  float effectiveRUncertainty;
+  float Rt;                     //! real-time R from the renewal equation
+  float RtUncertainty;
+  int   nQuarantineToday;
+};
+
+//! the columns, in the order of CVDayRecord
+enum CVColumnType : uint32_t { C_Int32, C_Float32 };
+static const int kCVNColumns = 13;
+static const char* const kCVColumnNames[kCVNColumns] = { 
+  "run", "day", "S", "E", "I", "R", "traced", "reported", "Re", "ReUncertainty", "Rt", "RtUncertainty", "quarantined" 
+};
+static const CVColumnType kCVColumnTypes[kCVNColumns] = { 
+  C_Int32, C_Int32, C_Int32, C_Int32, C_Int32, C_Int32, C_Int32, C_Int32, C_Float32, C_Float32, C_Float32, C_Float32, C_Int32 
+};
+static_assert(sizeof(CVDayRecord) == kCVNColumns*4, "CVDayRecord must hold one 4 byte value per column");
+
+//! on-disk structures
+struct CVColumnHeader {
+  char     magic[8];   //! "CVCOLS\0\0"
+  uint32_t version;
+  uint32_t nColumns;
+  uint32_t alignment;
+  uint32_t reserved[11];
+};
+struct CVColumnDescriptor {
+  char     name[24];
+  uint32_t type;       //! CVColumnType
+  uint32_t width;      //! bytes per value
+};
+struct CVColumnBatch {
+  int32_t  run;
+  int32_t  nRows;
+  uint32_t reserved[14];
+};
+struct CVColumnIndexEntry {
+  int32_t  run;
+  int32_t  nRows;
+  int64_t  offset;     //! of the CVColumnBatch
+};
+struct CVColumnTrailer {
+  int64_t  indexOffset;
+  int64_t  nRuns;
+  char     magic[8];
+  int64_t  reserved;
+};
+static_assert(sizeof(CVColumnHeader) == 64 && sizeof(CVColumnBatch) == 64, "header blocks must be 64 bytes");
+
+static const char     kCVColumnMagic[8]  = { 'C','V','C','O','L','S',0,0 };
+static const uint32_t kCVColumnVersion   = 1;
+static const uint32_t kCVColumnAlignment = 64;
+
+//! size of an array of .. bytes including the padding to the next aligned block
+inline int64_t CVColumnPadded(int64_t size) { return (size + kCVColumnAlignment-1)/kCVColumnAlignment*kCVColumnAlignment; }
+
+//! writes the runs one batch at a time, the index is written on close
+class CVColumnWriter
+{
+  public:
+    CVColumnWriter(string filename) : fFilename(filename), fOffset(0) {
+      fOutput.open(filename.c_str(), ios::binary | ios::trunc);
+      CVColumnHeader header = {};
+      memcpy(header.magic,kCVColumnMagic,8);
+      header.version   = kCVColumnVersion;
+      header.nColumns  = kCVNColumns;
+      header.alignment = kCVColumnAlignment;
+      Write(&header,sizeof(header));
+      vector<CVColumnDescriptor> columns(kCVNColumns);
+      for(int icol = 0; icol < kCVNColumns; icol++) {
+        strncpy(columns[icol].name,kCVColumnNames[icol],sizeof(columns[icol].name)-1);
+        columns[icol].type  = kCVColumnTypes[icol];
+        columns[icol].width = 4;
+      }
+      Write(&columns[0],columns.size()*sizeof(CVColumnDescriptor));
+    }
+    ~CVColumnWriter() { Close(); }
+
+    string GetFilename() { return fFilename; }
+    bool   IsOpen()      { return fOutput.is_open(); }
+
+    //! append the days of one run as a batch of columns
+    void WriteRun(int run, const vector<CVDayRecord>& days) {
+      int nrows = days.size();
+      fIndex.push_back({ run, nrows, fOffset });
+      CVColumnBatch batch = {};
+      batch.run   = run;
+      batch.nRows = nrows;
+      Write(&batch,sizeof(batch));
+      //! transpose the records, one column at a time
+      vector<uint32_t> column(nrows);
+      for(int icol = 0; icol < kCVNColumns; icol++) {
+        for(int irow = 0; irow < nrows; irow++) memcpy(&column[irow],(const char*) &days[irow] + 4*icol,4);
+        Write(column.data(),4*nrows);
+      }
+    }
+    void Close() {
+      if(!IsOpen()) return;
+      CVColumnTrailer trailer = {};
+      trailer.indexOffset = fOffset;
+      trailer.nRuns       = fIndex.size();
+      memcpy(trailer.magic,kCVColumnMagic,8);
+      if(!fIndex.empty()) Write(&fIndex[0],fIndex.size()*sizeof(CVColumnIndexEntry));
+      fOutput.write((const char*) &trailer,sizeof(trailer));
+      fOutput.close();
+    }
+
+  private:
+    //! write and pad to the alignment
+    void Write(const void* data, int64_t size) {
+      static const char zeros[kCVColumnAlignment] = {};
+      fOutput.write((const char*) data,size);
+      fOutput.write(zeros,CVColumnPadded(size)-size);
+      fOffset += CVColumnPadded(size);
+    }
+
+    string   fFilename;
+    ofstream fOutput;
+    int64_t  fOffset;                    //! where the next block starts
+    vector<CVColumnIndexEntry> fIndex;   //! batches written so far
+};
+
+//! maps a file and gives access to the columns of every run in place
+class CVColumnReader
+{
+  public:
+    CVColumnReader(string filename) : fData(0), fSize(0) {
+      int fd = open(filename.c_str(), O_RDONLY);
+      if(fd < 0) return;
+      struct stat st;
+      if(fstat(fd,&st) == 0 && st.st_size >= (off_t) (sizeof(CVColumnHeader)+sizeof(CVColumnTrailer))) {
+        void* data = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if(data != MAP_FAILED) { 
+          fData = (const char*) data; 
+          fSize = st.st_size; 
+      } }
+      close(fd);
+      if(fData && !ReadIndex()) {
+        munmap((void*) fData, fSize);
+        fData = 0;
+      }
+    }
+    ~CVColumnReader() { if(fData) munmap((void*) fData, fSize); }
+
+    bool IsOpen() { return fData != 0; }
+
+    //! runs in the order they were written
+    int GetNRuns()          { return fIndex.size(); }
+    int GetRun(int irun)    { return fIndex[irun].run;   }
+    int GetNRows(int irun)  { return fIndex[irun].nRows; }
+    //! position of run .. in the file, -1 if not present
+    int FindRun(int run) { 
+      map<int,int>::iterator it = fRunPosition.find(run);
+      return it == fRunPosition.end() ? -1 : it->second; 
+    }
+    //! column number of .., -1 if not present
+    int FindColumn(string name) {
+      for(int icol = 0; icol < (int) fColumns.size(); icol++) if(name == fColumns[icol].name) return icol;
+      return -1;
+    }
+    int    GetNColumns()             { return fColumns.size(); }
+    string GetColumnName(int icol)   { return fColumns[icol].name; }
+    CVColumnType GetColumnType(int icol) { return CVColumnType(fColumns[icol].type); }
+
+    //! the values of a column of a run, in place
+    const int32_t* GetInt(int irun, int icol)   { return (const int32_t*) GetColumn(irun,icol); }
+    const float*   GetFloat(int irun, int icol) { return (const float*)   GetColumn(irun,icol); }
+    //! rows [first, last) of run .. that hold the days from .. to .. (both inclusive)
+    pair<int,int> GetDayRange(int irun, int firstDay, int lastDay) {
+      const int32_t* days = GetInt(irun,FindColumn("day"));
+      int nrows = GetNRows(irun);
+      return make_pair(lower_bound(days,days+nrows,firstDay)-days, upper_bound(days,days+nrows,lastDay)-days);
+    }
+
+  private:
+    const char* GetColumn(int irun, int icol) {
+      int64_t offset = fIndex[irun].offset + sizeof(CVColumnBatch);
+      for(int jcol = 0; jcol < icol; jcol++) offset += CVColumnPadded(int64_t(fColumns[jcol].width)*fIndex[irun].nRows);
+      return fData + offset;
+    }
+    bool ReadIndex() {
+      const CVColumnHeader*  header  = (const CVColumnHeader*) fData;
+      const CVColumnTrailer* trailer = (const CVColumnTrailer*) (fData + fSize - sizeof(CVColumnTrailer));
+      if(memcmp(header->magic,kCVColumnMagic,8) || memcmp(trailer->magic,kCVColumnMagic,8)) return false;
+      if(header->version != kCVColumnVersion) return false;
+      if(trailer->indexOffset < 0 || trailer->indexOffset + trailer->nRuns*(int64_t) sizeof(CVColumnIndexEntry) > fSize) return false;
+      const CVColumnDescriptor* columns = (const CVColumnDescriptor*) (fData + sizeof(CVColumnHeader));
+      fColumns.assign(columns, columns + header->nColumns);
+      const CVColumnIndexEntry* index = (const CVColumnIndexEntry*) (fData + trailer->indexOffset);
+      fIndex.assign(index, index + trailer->nRuns);
+      for(int irun = 0; irun < (int) fIndex.size(); irun++) fRunPosition[fIndex[irun].run] = irun;
+      return true;
+    }
+
+    const char* fData;  //! the mapped file
+    int64_t     fSize;
+    vector<CVColumnDescriptor> fColumns;
+    vector<CVColumnIndexEntry> fIndex;
+    map<int,int>               fRunPosition; //! run -> position in fIndex
+};
+
+#endif
@@ -0,0 +1,141 @@
+'''
+Reads the column file of the daily census written by runCVMC -c (layout in CVColumnFile.h)
+without root. The file is memory mapped and the columns of a run are returned as views of
+the mapping: memoryviews by default, numpy arrays or pyarrow tables if those are installed.
+Run as a script to convert the file to an Arrow IPC (feather) file with one record batch
+per run.
+
+usage: python3 CVColumns.py file.cvcol [--run N] [--first D] [--last D] [--arrow out.arrow]
+'''
+import argparse
+import mmap
+import struct
+import sys
+
+
+MAGIC = b"CVCOLS\0\0"
+VERSION = 1
+HEADER = struct.Struct("<8sIII44x")      # magic, version, nColumns, alignment
+DESCRIPTOR = struct.Struct("<24sII")     # name, type, width
+BATCH = struct.Struct("<ii56x")          # run, nRows
+INDEXENTRY = struct.Struct("<iiq")       # run, nRows, offset
+TRAILER = struct.Struct("<qq8sq")        # indexOffset, nRuns, magic
+TYPECODES = {0: "i", 1: "f"}             # int32, float32
+
+
+class CVColumnFile:
+	'''
+	Memory mapped column file, runs are looked up through the index at the end of the file
+	'''
+	def __init__(self, filename):
+		self.file = open(filename, "rb")
+		self.data = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+		magic, version, ncolumns, self.alignment = HEADER.unpack_from(self.data, 0)
+		indexoffset, nruns, trailermagic = TRAILER.unpack_from(self.data, len(self.data) - TRAILER.size)[:3]
+		if magic != MAGIC or trailermagic != MAGIC:
+			raise ValueError("%s is not a column file" % filename)
+		if version != VERSION:
+			raise ValueError("column file version %d is not supported" % version)
+		self.columns = []
+		for icol in range(ncolumns):
+			name, type, width = DESCRIPTOR.unpack_from(self.data, HEADER.size + icol * DESCRIPTOR.size)
+			self.columns.append((name.rstrip(b"\0").decode(), type, width))
+		self.runs = {}
+		for irun in range(nruns):
+			run, nrows, offset = INDEXENTRY.unpack_from(self.data, indexoffset + irun * INDEXENTRY.size)
+			self.runs[run] = (nrows, offset)
+
+	def close(self):
+		self.data.close()
+		self.file.close()
+
+	def Padded(self, size):
+		return (size + self.alignment - 1) // self.alignment * self.alignment
+
+	def ColumnNames(self):
+		return [name for name, type, width in self.columns]
+
+	'''
+	Views of the columns of a run, {name: memoryview}, no data is copied
+	'''
+	def GetRun(self, run):
+		nrows, offset = self.runs[run]
+		offset += BATCH.size
+		view = memoryview(self.data)
+		columns = {}
+		for name, type, width in self.columns:
+			columns[name] = view[offset:offset + width * nrows].cast(TYPECODES[type])
+			offset += self.Padded(width * nrows)
+		return columns
+
+	'''
+	Views of the rows of a run that hold the days from first to last (both inclusive)
+	'''
+	def GetDays(self, run, first, last):
+		columns = self.GetRun(run)
+		days = columns["day"]
+		begin = next((irow for irow in range(len(days)) if days[irow] >= first), len(days))
+		end = next((irow for irow in range(begin, len(days)) if days[irow] > last), len(days))
+		return dict((name, column[begin:end]) for name, column in columns.items())
+
+	'''
+	Columns of a run as numpy arrays, still views of the mapping
+	'''
+	def GetRunNumpy(self, run):
+		import numpy
+		return dict((name, numpy.frombuffer(column, dtype=numpy.dtype("<" + column.format + "4")))
+		            for name, column in self.GetRun(run).items())
+
+	'''
+	A run as pyarrow record batch, the buffers are 64 byte aligned as arrow expects
+	'''
+	def GetRunArrow(self, run):
+		import pyarrow
+		columns = self.GetRun(run)
+		arrays = [pyarrow.Array.from_buffers(ArrowType(column.format), len(column), [None, pyarrow.py_buffer(column)])
+		          for column in columns.values()]
+		return pyarrow.RecordBatch.from_arrays(arrays, names=list(columns.keys()))
+
+	'''
+	The arrow schema of the columns, from the header, so also for a file without runs
+	'''
+	def GetArrowSchema(self):
+		import pyarrow
+		return pyarrow.schema([(name, ArrowType(TYPECODES[type])) for name, type, width in self.columns])
+
+
+def ArrowType(typecode):
+	import pyarrow
+	return {"i": pyarrow.int32(), "f": pyarrow.float32()}[typecode]
+
+
+def main():
+	parser = argparse.ArgumentParser(description="read the CVMC column file")
+	parser.add_argument("file")
+	parser.add_argument("--run", type=int, help="only this run")
+	parser.add_argument("--first", type=int, default=0, help="first day")
+	parser.add_argument("--last", type=int, default=99999, help="last day")
+	parser.add_argument("--arrow", help="write an Arrow IPC file instead of printing (needs pyarrow)")
+	args = parser.parse_args()
+
+	columnfile = CVColumnFile(args.file)
+	runs = [args.run] if args.run is not None else list(columnfile.runs.keys())
+	if args.run is not None and args.run not in columnfile.runs:
+		print("Error, run %d is not in %s" % (args.run, args.file), file=sys.stderr)
+		return 1
+	if args.arrow:
+		import pyarrow
+		with pyarrow.ipc.new_file(args.arrow, columnfile.GetArrowSchema()) as writer:
+			for run in runs:
+				writer.write_batch(columnfile.GetRunArrow(run))
+		return 0
+	print("\t".join(columnfile.ColumnNames()))
+	for run in runs:
+		columns = list(columnfile.GetDays(run, args.first, args.last).values())
+		for irow in range(len(columns[0])):
+			print("\t".join("%g" % column[irow] if column.format == "f" else str(column[irow]) for column in columns))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
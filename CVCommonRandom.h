@@ -0,0 +1,122 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Random numbers for common random number (CRN) comparisons of scenarios. Usually this is
+ * TRandom3 with one stream for the whole run: as soon as an intervention changes whether a
+ * draw is made (a quarantined person meets nobody), all later draws shift and two scenarios
+ * with the same seed are as different as two seeds. With common random numbers switched on,
+ * the draws come from keyed streams instead: the n-th number of the stream of (seed, purpose,
+ * person, day) is a hash of these, independent of all other draws of the run. The day loop
+ * selects the stream before each step (the contacts of a person on a day, the course of the
+ * disease of a person, their tests, ...), so a replicate sees the same world in every scenario
+ * and only what the interventions change differs.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVCommonRandom_H
+#define CVCommonRandom_H
+
+//! c++
+#include <cstdint>
+#include <string>
+
+//! root
+#include <TRandom3.h>
+#include <TBufferFile.h>
+
+#include "CVCheckpoint.h"
+
+using namespace std;
+
+//! what the numbers of a stream are used for
+enum CVRandomPurpose { R_AppUsers, R_Reporters, R_Course, R_Contacts, R_Tests, R_Tracing };
+
+class CVCommonRandom : public TRandom3
+{
+  public:
+    //! position in the keyed streams
+    struct State {
+      uint64_t stream, counter;
+    };
+
+    CVCommonRandom(unsigned int seed = 4357) : TRandom3(seed) {}
+
+    //! switch the keyed streams on or off (off: plain TRandom3)
+    void SetCommon(bool common = true) { fCommon = common; }
+    bool GetCommon() const { return fCommon; }
+
+    void SetSeed(ULong_t seed = 0) override {
+      TRandom3::SetSeed(seed);
+      fKey = Mix(GetSeed());
+      fState = { fKey, 0 };
+    }
+    //! continue with the stream of .. (no effect without common random numbers)
+    void SetStream(CVRandomPurpose purpose, uint64_t person = 0, uint64_t day = 0) {
+      if(!fCommon) return;
+      fState = { Mix(Mix(Mix(fKey ^ purpose) ^ person) ^ day), 0 };
+    }
+    State GetState() const { return fState; }
+    void  SetState(const State& state) { fState = state; }
+
+    //! in (0,1), like TRandom3
+    Double_t Rndm() override {
+      if(!fCommon) return TRandom3::Rndm();
+      return ((Mix(fState.stream + fState.counter++ * 0x9e3779b97f4a7c15ULL) >> 11) + 0.5) * (1./9007199254740992.);
+    }
+    void RndmArray(Int_t n, Float_t* array) override {
+      if(!fCommon) { TRandom3::RndmArray(n, array); return; }
+      for(Int_t i = 0; i < n; i++) array[i] = Rndm();
+    }
+    void RndmArray(Int_t n, Double_t* array) override {
+      if(!fCommon) { TRandom3::RndmArray(n, array); return; }
+      for(Int_t i = 0; i < n; i++) array[i] = Rndm();
+    }
+
+    //! checkpoint of the keyed streams and of the TRandom3 state, streamed by root (see CVCheckpoint.h)
+    void Write(CVCheckpointWriter& out) {
+      out.Write(fCommon); out.Write(fKey); out.Write(fState);
+      TBufferFile buffer(TBuffer::kWrite);
+      TRandom3::Streamer(buffer);
+      out.Write(string(buffer.Buffer(),buffer.Length()));
+    }
+    void Read(CVCheckpointReader& in) {
+      in.Read(fCommon); in.Read(fKey); in.Read(fState);
+      string streamed;
+      in.Read(streamed);
+      if(streamed.empty()) return;
+      TBufferFile buffer(TBuffer::kRead,streamed.size(),&streamed[0],kFALSE);
+      TRandom3::Streamer(buffer);
+    }
+
+  private:
+    //! splitmix64 finalizer
+    static uint64_t Mix(uint64_t x) {
+      x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+      x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    }
+
+    bool     fCommon = false;
+    uint64_t fKey = 0;       //! of the seed
+    State    fState = {0,0};
+};
+
+#endif
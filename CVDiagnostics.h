@@ -0,0 +1,192 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Diagnostic canvas comparing the drawn incubation, latent and infectiousness distributions
+ * with the input functions of the disease. Used by CVMC and by plotCVMC, which rebuilds the
+ * canvas from the histograms and settings stored in the output file.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVDiagnostics_H
+#define CVDiagnostics_H
+
+//! c++
+#include <iostream>
+#include <string>
+
+//! root
+#include <TH1F.h>
+#include <TGraph.h>
+#include <TCanvas.h>
+#include <TLegend.h>
+#include <TLegendEntry.h>
+#include <TStyle.h>
+#include <TPad.h>
+#include "CVDisease.h"
+
+using namespace std;
+
+// because ROOT can't make a decent legend automatically
+inline void makeLegend(TLegend *ll, TPad *pad, int location=0)
+{
+  if (!pad || !ll) {
+    cout << "Cannet make legend dimensions without pad or legend pointer. Please use makeDSLegend(legend, pad)." << endl;
+    return;
+  }
+  pad->cd();
+
+  // hardcoded constants that determine the size and spacing of legend entries
+  int legendTextSize = gStyle->GetLabelSize() - 2; //px
+  float legendSampleLength = 0.3; // length of sample lines as fraction of legend width
+  int legendEntryPadding = 2; // vertical padding between entries
+  int gapBetweenSampleAndLabel = 15; // px  horizontal distance between the sample line and the label
+
+  // get some info about pad size and legend rows; this is used to figure out the dimensions of the legend box
+  int padHeightinPx = gPad->VtoPixel(0);
+  int padWidthinPx = gPad->UtoPixel(1);
+  int legendRowsN = ll->GetNRows(); // how many entries are in this legend
+
+  // utility variables to store legend data we need to determine legend dimensions
+  TLegendEntry* entry;  // a pointer to each entry
+  int longestLabel = 0;  // count how long the labels are
+  string legendHeader = ""; // is there a header?
+  gStyle->SetLegendFont(gStyle->GetLegendFont());
+  ll->SetTextAlign(12);
+  ll->SetTextSize(legendTextSize);
+  ll->SetMargin(legendSampleLength); // length of sample lines as fraction of legend width
+
+  // I guess legends are exempt from the general gStyle rules ...
+  ll->SetBorderSize(0);
+  ll->SetFillColor(kWhite);
+  ll->SetFillStyle(1001);
+
+  // determine height
+  float legendHeight = float((legendRowsN * (legendTextSize + 2*legendEntryPadding)))/float(padHeightinPx);
+  // determine width based on number of characters in labels
+
+  if (ll->GetHeader()) legendHeader = ll->GetHeader();
+  int iLegendRow = (legendHeader.size() < 2 ? 0 : 1) ;  // if there is a header, we skip it in the loop
+  for (; iLegendRow < ll->GetNRows(); iLegendRow++) {  // i = 0:  header, if there is one
+    entry = (TLegendEntry*)ll->GetListOfPrimitives()->At(iLegendRow);
+    string labelText = entry->GetLabel();
+    if ((int)labelText.size() > longestLabel) {
+      longestLabel = labelText.size();
+    }
+  }
+
+  // determine width
+
+  // average width of text = (number of chars) * (size in px)/(font constant)
+  // font constant = 2.24 for Helvetica
+  float legendTextWidth = longestLabel * legendTextSize/2.24;
+  float legendWidth = legendTextWidth * (1 + legendSampleLength) + gapBetweenSampleAndLabel;
+  float titleWidth = legendHeader.size()* legendTextSize/2.24;
+  if (legendWidth < titleWidth) { // we cut off the title if the box isn't big enough
+    legendSampleLength = (titleWidth - legendTextWidth - gapBetweenSampleAndLabel)/titleWidth; // make samples longer so they aren't so far away from their labels
+    ll->SetMargin(legendSampleLength);
+    legendWidth = titleWidth;
+  }
+
+  legendWidth = float(legendWidth)/float(padWidthinPx);
+
+  /*** legend location ***/
+  switch (location) {
+    case 0:   // top right corner aligned with histogram top right corner
+      ll->SetY2NDC(1. - gPad->GetTopMargin() - 0.02);
+      ll->SetX2NDC(1 - gPad->GetRightMargin() - 0.02);
+      ll->SetY1NDC(ll->GetY2NDC() - legendHeight);
+      ll->SetX1NDC(ll->GetX2NDC() - legendWidth);
+      break;
+    case 1: // bottom right
+      ll->SetX2NDC(1 - gPad->GetRightMargin() - 0.02);
+      ll->SetY1NDC(gPad->GetBottomMargin() + 0.02);
+
+      ll->SetY2NDC(ll->GetY1NDC() + legendHeight);
+      ll->SetX1NDC(ll->GetX2NDC() - legendWidth);
+      break;
+
+    case 2: // top left
+      ll->SetY2NDC(1. - gPad->GetTopMargin() - 0.02);
+      ll->SetX1NDC(gPad->GetLeftMargin() + 0.02);
+      ll->SetX2NDC(ll->GetX1NDC() + legendWidth);
+      ll->SetY1NDC(ll->GetY2NDC() - legendHeight);
+      break;
+    case 3: // bottom left
+      ll->SetY1NDC(gPad->GetBottomMargin() + 0.02);
+      ll->SetX1NDC(gPad->GetLeftMargin() + 0.02);
+      ll->SetX2NDC(ll->GetX1NDC() + legendWidth);
+      ll->SetY2NDC(ll->GetY1NDC() + legendHeight);
+      break;
+  }
+  ll->Draw();
+}  
+
+//! draw copies of the histograms and of the disease functions on a new canvas, the test
+//! positive probability graph is returned in .. if given, otherwise owned by the canvas
+inline TCanvas* CVDrawDiagnostics(CVDisease* disease, TH1* hIncubationPeriod, TH1* hInfectiousness, TH1* hLatentPeriod, TGraph** testPositive=0) {
+  gStyle->SetOptStat(0);
+  gStyle->SetOptTitle(0);  
+  TCanvas *tc =new TCanvas("tc","tc");
+  TH1F *hdummy = new TH1F("hdummy",";day;probability",33,-3,30);
+  hdummy->SetDirectory(0);
+  hdummy->SetBit(TObject::kCanDelete);
+  hdummy->Draw();
+  hdummy->GetYaxis()->SetRangeUser(0.0, 1.0);
+    // Draw the test positive probability
+  float xvals[40];
+  float yvals[40];
+  int xycount = 0;
+  for (int iday = -3; iday < 30; iday++) {
+    xvals[xycount] = iday;
+    yvals[xycount] = disease->GetTestPositiveProb(iday);
+      xycount++;
+  }
+  TGraph *tcc  = new TGraph(xycount, &xvals[0], &yvals[0]);
+  tcc->SetMarkerStyle(2);
+  tcc->SetLineColor(1);
+  tcc->SetName("TestPositiveProb");
+  if (testPositive) *testPositive = tcc;
+  else tcc->SetBit(TObject::kCanDelete);
+  tcc->Draw("ALPsame");
+  
+  //! draw copies, the originals may be refilled or deleted while the canvas is still in use
+  disease->GetIncubationPeriod()->SetLineColor(kGray);
+  TObject* incubationPeriod = hIncubationPeriod->DrawClone("same");
+  disease->GetIncubationPeriod()->DrawClone("same");
+  disease->GetInfectiousness()->SetLineColor(kBlue-2);
+  disease->GetInfectiousness()->DrawClone("same");
+  TH1* infectiousness = (TH1*) hInfectiousness->DrawClone("same");
+  infectiousness->SetLineWidth(2);
+  TObject* latentPeriod = hLatentPeriod->DrawClone("same");
+  TLegend *fl = new TLegend();
+  fl->SetBit(TObject::kCanDelete);
+  fl->AddEntry(incubationPeriod, "Incubation Period" , "l");
+  fl->AddEntry(infectiousness, "Infectiousness relative to symptom start" , "l");
+  fl->AddEntry(latentPeriod, "Latent Period" , "l");
+  fl->AddEntry(tcc, "Test positive probability" , "lp");      
+  makeLegend(fl, tc, 1);
+  fl->Draw();
+  tc->Modified();
+  tc->Update();  
+  return tc;
+}
+
+#endif
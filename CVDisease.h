@@ -161,7 +161,7 @@ class CVDisease
     vector<CVInfectionStatus> DrawCourse() {
       vector<CVInfectionStatus> course;
       //! draw day of symptom onset
-      int dayOfSymptomOnset = (int) fIncubationPeriod->GetRandom();
+      int dayOfSymptomOnset = (int) fIncubationPeriod->GetRandom(fRandom);
       //! calculate backward from this day
       int latentDays = max(0,(int)(dayOfSymptomOnset-fAsymptomaticTime));  
       int asymptomaticInfectiousDays = dayOfSymptomOnset-latentDays;  
@@ -0,0 +1,236 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Bands of the daily census over an ensemble of runs: per day and quantity the mean and rms
+ * (Welford's running moments) and the 5%, 50% and 95% quantiles (DDSketch: the values are
+ * counted in logarithmic buckets, which gives every quantile to a relative accuracy alpha,
+ * the small ones exactly).
+ * The memory depends on the number of days and the range of the values, not on the number
+ * of runs, and the bands of several threads or files are merged without loss.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVEnsembleBands_H
+#define CVEnsembleBands_H
+
+//! c++
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+//! root
+#include <TTree.h>
+
+#include "CVColumnFile.h" //! CVDayRecord
+
+using namespace std;
+
+//! mean and variance of a stream of values, mergeable
+class CVRunningMoments
+{
+  public:
+    void Add(double x) {
+      fN++;
+      double delta = x - fMean;
+      fMean += delta/fN;
+      fM2   += delta*(x - fMean);
+    }
+    void Merge(const CVRunningMoments& other) {
+      if(other.fN == 0) return;
+      double n = fN + other.fN, delta = other.fMean - fMean;
+      fMean += delta*other.fN/n;
+      fM2   += other.fM2 + delta*delta*fN*other.fN/n;
+      fN = n;
+    }
+    double GetN()    const { return fN; }
+    double GetMean() const { return fMean; }
+    double GetRMS()  const { return fN > 0 ? sqrt(fM2/fN) : 0; }
+
+  private:
+    double fN = 0, fMean = 0, fM2 = 0;
+};
+
+//! quantiles of a stream of counts to a relative accuracy alpha, mergeable (DDSketch): counts
+//! below 1/alpha are kept exactly, larger ones in logarithmic buckets (gamma^(k-1), gamma^k]
+class CVQuantileSketch
+{
+  public:
+    CVQuantileSketch(double alpha = 0.01) : fLogGamma(log((1+alpha)/(1-alpha))), fExact(ceil(1/alpha)) {}
+
+    void Add(double x) {
+      fN++;
+      if(x < fExact) {
+        if(fCounts.empty()) fCounts.assign(fExact,0);
+        fCounts[max(0,int(lround(x)))]++;
+        return;
+      }
+      int key = ceil(log(x)/fLogGamma);
+      Grow(key, key);
+      fBins[key-fOffset]++;
+    }
+    void Merge(const CVQuantileSketch& other) {
+      fN += other.fN;
+      if(!other.fCounts.empty()) {
+        if(fCounts.empty()) fCounts.assign(fExact,0);
+        for(int icount = 0; icount < fExact; icount++) fCounts[icount] += other.fCounts[icount];
+      }
+      if(other.fBins.empty()) return;
+      Grow(other.fOffset, other.fOffset+other.fBins.size()-1);
+      for(size_t ibin = 0; ibin < other.fBins.size(); ibin++) fBins[other.fOffset+ibin-fOffset] += other.fBins[ibin];
+    }
+    //! value below which a fraction q of the values are (the lower one of two at the same rank)
+    double GetQuantile(double q) const {
+      if(fN == 0) return 0;
+      uint64_t rank = q*(fN-1), count = 0;
+      for(size_t icount = 0; icount < fCounts.size(); icount++) {
+        count += fCounts[icount];
+        if(rank < count) return icount;
+      }
+      for(size_t ibin = 0; ibin < fBins.size(); ibin++) {
+        count += fBins[ibin];
+        //! the value with the smallest relative distance to all in the bucket
+        if(rank < count) return 2*exp((int(ibin)+fOffset)*fLogGamma)/(exp(fLogGamma)+1);
+      }
+      return 2*exp((int(fBins.size())-1+fOffset)*fLogGamma)/(exp(fLogGamma)+1);
+    }
+    uint64_t GetN() const { return fN; }
+
+  private:
+    //! make room for the buckets first to last
+    void Grow(int first, int last) {
+      if(fBins.empty()) { fOffset = first; fBins.assign(last-first+1,0); return; }
+      if(first < fOffset) { fBins.insert(fBins.begin(), fOffset-first, 0); fOffset = first; }
+      if(last >= fOffset+(int) fBins.size()) fBins.resize(last-fOffset+1, 0);
+    }
+
+    double   fLogGamma;
+    int      fExact;          //! counts below this are kept exactly
+    vector<uint32_t> fCounts; //! of the values 0, 1, .. fExact-1, empty until the first
+    vector<uint32_t> fBins;   //! counts of the buckets fOffset, fOffset+1, ..
+    int      fOffset = 0;
+    uint64_t fN = 0;
+};
+
+//! the quantities with bands
+enum CVBandQuantity { B_Susceptible, B_Exposed, B_Infectious, B_Recovered, B_Reported, B_Quarantined, B_COUNT };
+static const char* const kCVBandNames[B_COUNT] = { "S", "E", "I", "R", "reported", "quarantined" };
+
+class CVEnsembleBands
+{
+  public:
+    //! quantiles of the bands
+    static const int kNQuantiles = 3;
+
+    CVEnsembleBands(double alpha = 0.01) : fAlpha(alpha), fNRuns(0) {}
+
+    //! the days of a run; a run that ended before lastDay is carried at its last state to it
+    void AddRun(const vector<CVDayRecord>& days, int lastDay) {
+      if(days.empty()) return;
+      int nDays = max(lastDay+1, days.back().day+1);
+      if((int) fMoments.size() < nDays) {
+        fMoments.resize(nDays);
+        array<CVQuantileSketch,B_COUNT> empty;
+        empty.fill(CVQuantileSketch(fAlpha));
+        fSketches.resize(nDays, empty);
+      }
+      size_t irecord = 0;
+      for(int iday = days.front().day; iday < nDays; iday++) {
+        while(irecord+1 < days.size() && days[irecord+1].day <= iday) irecord++;
+        for(int iq = 0; iq < B_COUNT; iq++) {
+          double value = GetValue(days[irecord], CVBandQuantity(iq));
+          fMoments[iday][iq].Add(value);
+          fSketches[iday][iq].Add(value);
+        }
+      }
+      fNRuns++;
+    }
+    void Merge(const CVEnsembleBands& other) {
+      if(fMoments.size() < other.fMoments.size()) {
+        fMoments.resize(other.fMoments.size());
+        array<CVQuantileSketch,B_COUNT> empty;
+        empty.fill(CVQuantileSketch(fAlpha));
+        fSketches.resize(other.fSketches.size(), empty);
+      }
+      for(size_t iday = 0; iday < other.fMoments.size(); iday++)
+        for(int iq = 0; iq < B_COUNT; iq++) {
+          fMoments[iday][iq].Merge(other.fMoments[iday][iq]);
+          fSketches[iday][iq].Merge(other.fSketches[iday][iq]);
+        }
+      fNRuns += other.fNRuns;
+    }
+
+    long   GetNRuns() const { return fNRuns; }
+    int    GetNDays() const { return fMoments.size(); }
+    double GetMean(int day, CVBandQuantity q) const { return fMoments.at(day)[q].GetMean(); }
+    double GetRMS (int day, CVBandQuantity q) const { return fMoments.at(day)[q].GetRMS(); }
+    double GetQuantile(int day, CVBandQuantity q, double p) const { return fSketches.at(day)[q].GetQuantile(p); }
+
+    //! one entry per day with the mean, rms, 5%, 50% and 95% quantile of every quantity
+    TTree* MakeTree(const char* name = "EnsembleBands") const {
+      static const double quantiles[kNQuantiles] = { 0.05, 0.5, 0.95 };
+      static const char* const quantileNames[kNQuantiles] = { "p5", "p50", "p95" };
+      TTree* tree = new TTree(name, "CV MC daily census over the runs");
+      int day, nRuns = 0;
+      vector<float> values(B_COUNT*(2+kNQuantiles));
+      tree->Branch("day",&day);
+      tree->Branch("nRuns",&nRuns);
+      for(int iq = 0; iq < B_COUNT; iq++) {
+        float* v = &values[iq*(2+kNQuantiles)];
+        tree->Branch(Form("%s_mean",kCVBandNames[iq]),v);
+        tree->Branch(Form("%s_rms", kCVBandNames[iq]),v+1);
+        for(int ip = 0; ip < kNQuantiles; ip++) tree->Branch(Form("%s_%s",kCVBandNames[iq],quantileNames[ip]),v+2+ip);
+      }
+      for(day = 0; day < GetNDays(); day++) {
+        nRuns = fMoments[day][0].GetN();
+        for(int iq = 0; iq < B_COUNT; iq++) {
+          float* v = &values[iq*(2+kNQuantiles)];
+          v[0] = GetMean(day,CVBandQuantity(iq));
+          v[1] = GetRMS(day,CVBandQuantity(iq));
+          for(int ip = 0; ip < kNQuantiles; ip++) v[2+ip] = GetQuantile(day,CVBandQuantity(iq),quantiles[ip]);
+        }
+        tree->Fill();
+      }
+      tree->ResetBranchAddresses();
+      return tree;
+    }
+
+  private:
+    static double GetValue(const CVDayRecord& day, CVBandQuantity q) {
+      switch(q) {
+        case B_Susceptible: return day.nSusceptible;
+        case B_Exposed:     return day.nExposed;
+        case B_Infectious:  return day.nInfectious;
+        case B_Recovered:   return day.nRecovered;
+        case B_Reported:    return day.nReported;
+        case B_Quarantined: return day.nQuarantineToday;
+        default:            return 0;
+      }
+    }
+
+    double fAlpha;
+    long   fNRuns;
+    vector<array<CVRunningMoments,B_COUNT> > fMoments;  //! by day
+    vector<array<CVQuantileSketch,B_COUNT> > fSketches;
+};
+
+#endif
@@ -0,0 +1,149 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Binary record of individual events (exposure, report, test, trace, quarantine, release).
+ * Each simulation owns a CVEventLog that buffers fixed-size records and hands them in
+ * blocks to a CVEventFile, which may be shared between simulations.
+ * Does not depend on root, so that the reader can be built anywhere.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVEventLog_H
+#define CVEventLog_H
+
+//! c++
+#include <vector>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+//! posix
+#include <unistd.h>
+
+using namespace std;
+
+//! the kind of event that was recorded
+enum CVEventType : uint8_t {
+  E_Exposure,   ///< 0 - person got exposed;        value: ID of infector (-3 for patient 0)
+  E_Report,     ///< 1 - person will be reported;   value: day of report,  detail: CVReportReason
+  E_Test,       ///< 2 - person was tested;         value: 1 if positive,  detail: CVReportReason
+  E_Trace,      ///< 3 - contact trace was tried;   value: ID traced from, detail: trace level (1,2) or 98 (missed), 99 (too far back)
+  E_Quarantine, ///< 4 - person sent to quarantine; value: days added,    detail: CVReportReason
+  E_Release,    ///< 5 - released after negative test; value: days removed
+  Event_COUNT   ///< Do not add anything after COUNT
+};
+
+//! why a person got tested or reported
+enum CVReportReason : uint8_t {
+  R_Symptoms,    ///< 0 - symptomatic and went to the doctor
+  R_Traced,      ///< 1 - first test after being traced
+  R_Retest,      ///< 2 - second test in quarantine
+  R_RandomTest,  ///< 3 - selected for a random test
+  R_Contact,     ///< 4 - uninfected contact of a reported person
+  Reason_COUNT   ///< Do not add anything after COUNT
+};
+
+//! one event, 16 bytes on disk
+struct CVEvent {
+  int32_t run;    //! run index (fileIndex)
+  int16_t day;    //! day of the outbreak
+  uint8_t type;   //! CVEventType
+  uint8_t detail; //! type dependent, see CVEventType
+  int32_t person; //! ID of the person concerned
+  int32_t value;  //! type dependent, see CVEventType
+};
+static_assert(sizeof(CVEvent) == 16, "CVEvent must stay 16 bytes");
+
+//! names used by the reader
+static const char* const kCVEventNames[Event_COUNT] = { "exposure", "report", "test", "trace", "quarantine", "release" };
+
+//! file all event logs write their blocks to. Starts with a small header: magic, version, record size.
+class CVEventFile
+{
+  public:
+    CVEventFile(string filename) : fFilename(filename) {
+      fOutput.open(filename.c_str(), ios::binary | ios::trunc);
+      int32_t header[4] = { kMagic, kVersion, (int32_t) sizeof(CVEvent), 0 };
+      fOutput.write((const char*) header, sizeof(header));
+    }
+    //! continue a file after its first .. bytes, e.g. those written up to a checkpoint
+    CVEventFile(string filename, int64_t size) : fFilename(filename) {
+      if(truncate(filename.c_str(), size) == 0) fOutput.open(filename.c_str(), ios::binary | ios::app | ios::ate);
+    }
+    ~CVEventFile() { fOutput.close(); }
+
+    string GetFilename() { return fFilename; }
+    bool   IsOpen()      { return fOutput.is_open(); }
+    //! bytes written so far
+    int64_t GetSize() {
+      lock_guard<mutex> lock(fMutex);
+      return fOutput.tellp();
+    }
+
+    //! append a block of records, callable from several simulation threads
+    void Write(const CVEvent* events, size_t n) {
+      if(n == 0) return;
+      lock_guard<mutex> lock(fMutex);
+      fOutput.write((const char*) events, n*sizeof(CVEvent));
+      fOutput.flush();
+    }
+
+    static const int32_t kMagic   = 0x56455643; //! "CVEV"
+    static const int32_t kVersion = 1;
+
+  private:
+    string   fFilename;
+    ofstream fOutput;
+    mutex    fMutex;
+};
+
+//! per-simulation ring buffer, flushed to the file whenever it is full
+class CVEventLog
+{
+  public:
+    CVEventLog(CVEventFile* file, size_t capacity=8192) : fFile(file), fNEvents(0) {
+      fEvents.resize(capacity);
+    }
+    ~CVEventLog() { Flush(); }
+
+    void Record(int run, int day, CVEventType type, int person, int value=0, int detail=0) {
+      CVEvent& event = fEvents[fNEvents];
+      event.run    = run;
+      event.day    = (int16_t) day;
+      event.type   = type;
+      event.detail = (uint8_t) detail;
+      event.person = person;
+      event.value  = value;
+      if(++fNEvents == fEvents.size()) Flush();
+    }
+    void Flush() {
+      fFile->Write(&fEvents[0],fNEvents);
+      fNEvents = 0;
+    }
+    CVEventFile* GetFile() { return fFile; }
+
+  private:
+    CVEventFile*    fFile;    //! not owned
+    vector<CVEvent> fEvents;  //! the ring buffer
+    size_t          fNEvents; //! filled records
+};
+
+#endif
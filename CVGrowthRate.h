@@ -0,0 +1,143 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Exponential growth rate and doubling time of daily counts, e.g. of new exposures, from a
+ * weighted least squares fit of a straight line to their logarithm. The weights are the
+ * counts (the variance of log(n) is 1/n for Poisson counts), so the fit is closed form and
+ * the sums are updated as days are added and leave the window: O(1) per day, compared to
+ * the iterative TF1 fit in CVPostProcess. The uncertainty is scaled up by the reduced chi2
+ * when the counts fluctuate more than Poisson counts.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVGrowthRate_H
+#define CVGrowthRate_H
+
+//! c++
+#include <deque>
+#include <cmath>
+#include <algorithm>
+
+#include "CVCheckpoint.h"
+
+using namespace std;
+
+class CVGrowthRate
+{
+  public:
+    //! returned if the counts are too few for an estimate
+    static constexpr double kNoEstimate = -99999;
+
+    //! fit the last .. days added (0=all days since the reset), if they have at least
+    //! minTotal counts on minDays days with counts
+    CVGrowthRate(int window = 0, double minTotal = 50, int minDays = 3)
+      : fWindow(window), fMinTotal(minTotal), fMinDays(minDays) { Reset(); }
+
+    void Reset() {
+      fDays.clear();
+      fNDays = 0;
+      fSw = fSwt = fSwtt = fSwy = fSwty = fSwyy = 0;
+    }
+    //! count on day, days are added in order
+    void AddDay(int day, double count) {
+      if(fDays.empty()) fOrigin = day;
+      fDays.push_back(make_pair(day,count));
+      Add(day, count, 1);
+      while(fWindow > 0 && fDays.front().first <= day-fWindow) {
+        Add(fDays.front().first, fDays.front().second, -1);
+        fDays.pop_front();
+      }
+    }
+
+    //! growth per day of the counts, n(t) ~ exp(rate*t)
+    double GetRate() const {
+      if(!IsValid()) return kNoEstimate;
+      return (fSw*fSwty - fSwt*fSwy)/Determinant();
+    }
+    double GetRateUncertainty() const {
+      if(!IsValid()) return kNoEstimate;
+      return sqrt(fSw/Determinant()*GetChi2Scale());
+    }
+    //! counts fitted on the day, exp of the intercept
+    double GetAmplitude(int day) const {
+      if(!IsValid()) return kNoEstimate;
+      double rate = GetRate();
+      return exp((fSwtt*fSwy - fSwt*fSwty)/Determinant() + rate*(day-fOrigin));
+    }
+    //! days for the counts to double, negative if they decline (the halving time)
+    double GetDoublingTime() const {
+      double rate = GetRate();
+      return rate == kNoEstimate || rate == 0 ? kNoEstimate : log(2.)/rate;
+    }
+    double GetDoublingTimeUncertainty() const {
+      double rate = GetRate();
+      return rate == kNoEstimate || rate == 0 ? kNoEstimate : log(2.)*GetRateUncertainty()/(rate*rate);
+    }
+    //! days with counts and their sum in the fit
+    int    GetNDays() const { return fNDays; }
+    double GetTotal() const { return fSw; }
+
+    //! checkpoint of the days in the window and the sums (see CVCheckpoint.h)
+    void Write(CVCheckpointWriter& out) const {
+      out.Write(vector<pair<int,double> >(fDays.begin(),fDays.end()));
+      out.Write(fOrigin); out.Write(fNDays);
+      double sums[] = { fSw, fSwt, fSwtt, fSwy, fSwty, fSwyy };
+      out.Write(sums);
+    }
+    void Read(CVCheckpointReader& in) {
+      vector<pair<int,double> > days;
+      in.Read(days);
+      fDays.assign(days.begin(),days.end());
+      in.Read(fOrigin); in.Read(fNDays);
+      double sums[6];
+      in.Read(sums);
+      fSw = sums[0]; fSwt = sums[1]; fSwtt = sums[2]; fSwy = sums[3]; fSwty = sums[4]; fSwyy = sums[5];
+    }
+
+  private:
+    //! days are counted from the first one added, to keep the sums small
+    void Add(int day, double count, int sign) {
+      if(count <= 0) return;
+      double t = day-fOrigin, y = log(count), w = sign*count;
+      fNDays += sign;
+      fSw   += w;     fSwt  += w*t;   fSwtt += w*t*t;
+      fSwy  += w*y;   fSwty += w*t*y; fSwyy += w*y*y;
+    }
+    bool IsValid() const { return fNDays >= max(fMinDays,3) && fSw >= fMinTotal && Determinant() > 0; }
+    double Determinant() const { return fSw*fSwtt - fSwt*fSwt; }
+    //! reduced chi2 of the fit if above one
+    double GetChi2Scale() const {
+      double D = Determinant();
+      double b = (fSw*fSwty - fSwt*fSwy)/D, a = (fSwtt*fSwy - fSwt*fSwty)/D;
+      double chi2 = fSwyy - 2*a*fSwy - 2*b*fSwty + a*a*fSw + 2*a*b*fSwt + b*b*fSwtt;
+      return max(1., chi2/(fNDays-2));
+    }
+
+    int    fWindow;
+    double fMinTotal;
+    int    fMinDays;
+    deque<pair<int,double> > fDays; //! days in the window and their counts
+    int    fOrigin;
+    int    fNDays;                  //! days with counts in the window
+    double fSw, fSwt, fSwtt, fSwy, fSwty, fSwyy; //! weighted sums of t, log(n) and their products
+};
+
+#endif
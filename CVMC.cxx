@@ -24,198 +24,55 @@ DEALINGS IN THE SOFTWARE.
  */
  
 #include "CVMC.h"
+#include "json.hpp"
 
 using namespace std;
 
 int CVPerson::nextId = 0; //don't like it here, but otherwise we get compiler issues
 
-void CVMC::DoMC() { 
+void CVMC::DoMC(CVSnapshot* from) { 
   if(fDebug) cout << "* starting run " << fRunId << endl;
   
   //! initialize stopwatch to take runtime
   TStopwatch stopwatch;
   Reset();
-  //! people stacks
-  list<CVPerson*> inRotation;   //! people who are exposed and not yet recovered
-  list<CVPerson*> inQuarantine; //! people who are healthy but in quarantine
-  
-  list<CVPerson*> toErase; //! people who have recovered and should be removed before the next loop
-  
-  vector<int> timeOrderedListOfInfectedIDs; //! People are added here sorted by day they were infected; this is used in the dot output chart
   //! text ouput
   if (fDebug) {
     fOutputTSV.open(Form("%s_%d.txt",fOutputPrefix.c_str(),fRunId)); 
     AddHeaderToTSV();
   }
-  //! root output
-  fOutputRoot = new TFile(Form("%s_%d.root",fOutputPrefix.c_str(),fRunId),"recreate");
+  //! root output, unless only the summary is written (a file of its own is written by a thread)
+  if (!fSummaryOutput && !fOutput) ROOT::EnableThreadSafety();
+  fOutputRoot = fSummaryOutput ? 0 : fOutput ? fOutput : new CVOutput(Form("%s_%d.root",fOutputPrefix.c_str(),fRunId));
   
-  //! seed "patient 0"
-  fPersons.front()->Expose(0,fDisease);  
-  fPersons.front()->SetInfectedBy(-3);
-  inRotation.push_back(fPersons.front()); 
-  timeOrderedListOfInfectedIDs.push_back(0);
-  int totalReported = 0; 
-  int totalSick = 0;
-  //! Loop over days in the outbreak
-  for(int iday = 0; iday < fNDays-1; iday++) {  
-    //! Infrastructure for .dot output.
-    if (fPeopleInDotFile < fMaxPeopleInDotFile) fLastDayForDot = iday;  
-    if (fPeopleInDotFile < 2.*fMaxPeopleInDotFile) fLastDayForDotSimple = iday;
-    if (iday%50 == 0) cout << "Passed day " << iday << endl;
-    if(fDebug) cout << endl << "**** Working on day " << iday << endl;
-    fNExposed = 0; fNInfectious = 0; fNTraced = 0; fNReported = 0; fNQuarantineToday=0;  
-      
-    //! remove people who have recovered
-    for(auto kv : toErase) inRotation.remove(kv);
-    toErase.clear();
-    if(inRotation.size() < 1) { 
-      if (fDebug) cout << "No sick people left. Exiting day loop early." << endl; 
-      //! if no one is infected we don't have to keep going
-      break; 
-    }   
-      
-    int ninfector = 0; //! < Needed for R_e; how many people were sick today?
-    int ninfectee = 0; //! < Needed for R_e; how many people were newly exposed today
-    if (fDebug) cout << "Total reported " << totalReported << endl;
-    //! Link the start of interventions to the number of reported cases
-    if (float(totalSick)/float(fNPersons) > fStartTracingTestingInfectedFraction && fStartTracingOnDay > 9998) { 
-      fStartTracingOnDay = iday; fStartTestingOnDay = iday; fSocialDistancingFrom = iday;
-      if (fDebug) cout << "Started tracing, testing, and social distancing on day " << iday << " with " << totalReported << "/" << fNPersons  << "=" << float(totalReported)/float(fNPersons)<< "  > " << fStartTracingTestingInfectedFraction << endl;
-    }
-    
-    //! iterate on all people who are exposed and not yet recovered
-    for(auto kv : inRotation) {
-      if(fDebug) cout << endl << "=> person " << kv->GetId() << " exposed on day " << kv->GetExposedOn() << endl;         
-
-      //! get current status
-      CVInfectionStatus currentInfectionStatus  = kv->GetInfectionStatus(iday);
-      CVTracingStatus   currentTracingStatus    = kv->GetTracingStatus(iday);
-      bool              currentQuarantineStatus = kv->GetQuarantineStatus(iday);
-      if(fDebug) cout << " Day " << iday <<  " status:  infection " << currentInfectionStatus << ", tracing " << currentTracingStatus << ", quarantine " << currentQuarantineStatus << endl;
-      IncrementPopulationStatistics(currentInfectionStatus, currentTracingStatus);
-      //! Do some accounting if person recovered today
-      if(currentInfectionStatus == S_Recovered) { 
-        if(fDebug) {  cout << " 1 person removed from rotation " << endl;  fPeopleInDotFile++;  }
-        //! use them to calcualte R_e (we can't do it sooner as only here they have infected everyone they could have)
-        ninfector++;
-        ninfectee = ninfectee + kv->GetNExposed();
-        FillDiagnostics(kv, iday >= fStartTestingOnDay);
-        //! add to remove pile
-        toErase.push_back(kv); 
-        continue;  
-      }
-      
-      //! find new victims if infectious
-      if((currentInfectionStatus == S_ExposedInfectious || currentInfectionStatus == S_Infectious) 
-        //! .. but not quarantined
-        && currentQuarantineStatus == false) {
-        //! get todays infectiousness
-        float infProb = kv->GetDisease()->GetInfectiousness(iday-kv->GetSymptomOnset(),kv->GetHasSymptoms());
-        //! .. and the number of constacts
-        int meettoday = GetPeopleMetToday(iday);
-        if(fDebug) cout << " will meet " << meettoday << " and infect with probability " << infProb <<  endl;
-        //! draw number of victims
-        int ninfected = fRandom.Binomial(meettoday,infProb); 
-        if(fDebug) cout << " will infect " << ninfected << " others." <<  endl;
-        //! .. and remember how many people we met and did not infect (so we know how many to trace)
-        kv->AddUninfectedContacts(iday, meettoday-ninfected);
-        //! Now infect the victims ...
-        for(int iinfect = ninfected; iinfect--;) {
-          //! randomly pick the victim's ID
-          int pp = fRandom.Integer(fNPersons);
-          //! .. but not ourselves
-          if (pp == kv->GetId()) pp = (pp+1)%fNPersons;
-          //! only infect the person if not infected before and not in quarantine
-          if(fPersons.at(pp)->GetExposedOn()<0 && !fPersons.at(pp)->GetQuarantineStatus(iday)) {
-            if (fDebug) { cout << " adding exposed person " << pp << endl; AddConnectionToDot(kv->GetId(), pp, 0, iday); }
-            timeOrderedListOfInfectedIDs.push_back(pp); 
-            fPersons.at(pp)->Expose(iday,kv);
-            totalSick++;
-            inRotation.push_back(fPersons.at(pp));
-      } } }
-      
-      //! see if we can report a person .. only if not already reported
-      if(kv->GetReportedOn()<0) {
-        bool doesReport = false;
-        int reportday = iday;
-        //! .. if showing symptoms and person willing to see doctor/has access to test
-        if(currentInfectionStatus == S_Infectious && kv->GetHasSymptoms() && kv->GetDoesReport()) { 
-          doesReport = true; 
-        }
-        //! .. or if traced and then tested positive
-        if(currentTracingStatus == S_Traced  && iday > fStartTestingOnDay) { 
-          //! get days since the most recent time we got traced
-          int daysSinceTraced = iday - kv->GetTracedOn(kv->GetNTracedOn()-1);
-          //! .. and tested
-          int daysSinceTested = kv->GetDayLastTestedOn() > -1 ? iday - kv->GetDayLastTestedOn() : 9999;          
-          if (fDebug) cout << "Days since traced: " << daysSinceTraced << " and days since tested: " << daysSinceTested << endl;
-          //! if tracing is recent (today or yesterday) and no test was performed ...
-          if(daysSinceTraced <=1 && daysSinceTested > 2) {
-            //! .. test them
-            if(kv->GetTestsPositive(iday) ) { 
-              doesReport = true; 
-              //! .. but wait for the test result
-              reportday=reportday+fDaysToTestResult;
-              if (fDebug) cout << "Person " << kv->GetId() << " will be reported from testing positive on day " << reportday << endl;
-          } }
-          //! .. or re-test after some time in quarantine, this should cover the latent period
-          else if (daysSinceTested == fdTTest) { 
-            if (kv->GetTestsPositive(iday) ) { 
-              doesReport = true; 
-              reportday=reportday+fDaysToTestResult;
-              if (fDebug) cout << "Person " << kv->GetId() << " will be reported from testing positive on re-test on day " << reportday << endl;
-            }
-            //! .. if this turns out negative, release the person
-            else {
-              kv->ReleaseFromQuarantine(iday+fDaysToTestResult,fDaysInQuarantine);
-              if (fDebug) cout << "Person " << kv->GetId() << " released from quarantine due to negative second test." << endl;
-        } } }
-        //! .. or if selected for a random test
-        else if(fRandomTesting && iday > fStartTestingOnDay && fRandom.Uniform() < fRandomTestingRate) {
-          //! .. that is performed once
-          if(kv->GetTestsPositive(iday)) {
-            doesReport = true; 
-            reportday=reportday+fDaysToTestResult;  
-            if (fDebug) cout << "Person " << kv->GetId() << " will be reported from testing positive by random test on day " << reportday << endl;          
-        } }        
-        if(doesReport) {
-          kv->Report(reportday,fDaysInQuarantine); 
-          totalReported++;
-      } } 
-
-      //! reporting triggers tracing of
-      if (kv->GetReportedOn()+fTracingDelay == iday && iday > fStartTracingOnDay && kv->GetHasApp()) {
-        if(fDebug) cout << " tracing " << kv->GetNExposed()  << " people " << endl;
-        //! .. contacts you infected
-        for(auto kvv : kv->GetExposed()) {
-            Trace(fPersons.at(kvv),iday,kv->GetId(),1);
-        } 
-        //! .. the contact you got infected from (unless you are patient 0)
-        if(fBackwardTracing && kv->GetInfectedBy() >= 0) { 
-          Trace(fPersons.at(kv->GetInfectedBy()),iday,kv->GetId(),2);  
-        }
-        //! .. and a bunch of people you may have met but not infected
-        TraceUninfected(kv,iday);        
-      } 
-               
-    } //! end of sick people on this day
-    // check who is in quarantine
-    for (auto qkv : fPersons) { if (qkv->GetQuarantineStatus(iday)) fNQuarantineToday++; }
-    //! figure out R_t. 
-    fNumberRecoveredByDay.push_back(ninfector);
-    fNumberInfectiousByDay.push_back(fNInfectious);
-    numberNewlyInfectedByDay.push_back(ninfectee);
-    AddDayToTSVAndROOT(iday);
-    fLastDayWithPatients = iday;
-  } //! end of days
-   fNExposedTotal = 0;
+  //! continue another run from where its interventions started ..
+  if (from) RestoreSnapshot(*from);
+  else {
+    //! .. or seed "patient 0"
+    fRandom.SetStream(R_Course,0);
+    fPersons.front()->Expose(0,fDisease);  
+    fPersons.front()->SetInfectedBy(-3);
+    LogEvent(0,E_Exposure,0,-3);
+    fInRotation.push_back(fPersons.front()); 
+    fTimeOrderedListOfInfectedIDs.push_back(0);
+  }
+  //! Loop over days in the outbreak, compiled for the switches of this run
+  if (fTracingOrder > 2 || fTracingOrder < 1) cout << "DoMC:Parameter error: tracingOrder must be 1 or 2; is currently " << fTracingOrder << endl;
+  fFeatureSwitches[0] = fDebug;
+  fFeatureSwitches[1] = fRandomTesting;
+  fFeatureSwitches[2] = fBackwardTracing;
+  fFeatureSwitches[3] = fTraceUninfected;
+  fFeatureSwitches[4] = fTracingOrder == 2;
+  fFeatureSwitches[5] = fTiming;
+  SelectDayLoop<>();
+  if (fBands) fBands->AddRun(fRunOutput->days,fNDays-2);
+  fNExposedTotal = 0;
   for(auto kp : fPersons) {
     if (kp->GetExposedOn() > 0) { fNExposedTotal ++; }    
   }
   fPeopleInDotFile = 0;
   if (fDebug) {
-    for (auto pp :  timeOrderedListOfInfectedIDs) {
+    for (auto pp :  fTimeOrderedListOfInfectedIDs) {
       if (fPersons.at(pp)->GetExposedOn() > -1) AddPersonToDot(fPersons.at(pp));
     }
   }
@@ -246,13 +103,432 @@ void CVMC::DoMC() {
     WriteGnuplotScript();    
   }
 
-  WriteROOTFile();
+  TStopwatch writeStopwatch;
+  if (fSummaryOutput) WriteSummary();
+  else WriteROOTFile();
+  if(fOutputRoot != fOutput) delete fOutputRoot;
+  if(fEventLog) fEventLog->Flush();
+  //! a job that stops from here on continues with the next run
+  if (fCheckpointEvery > 0) WriteCheckpoint(-1);
+  if (fTiming) {
+    //! one parseable line per run, times in seconds
+    cout << "PerformanceInformation fileIndex=" << fRunId;
+    for(int iphase = 0; iphase < Phase_COUNT; iphase++) cout << " t" << kCVPhaseNames[iphase] << "=" << fTimer.GetRunTime(CVPhase(iphase))*1e-6;
+    cout << " tWrite=" << writeStopwatch.RealTime();
+    for(int iitem = 0; iitem < Work_COUNT; iitem++) cout << " n" << kCVWorkItemNames[iitem] << "=" << fTimer.GetRunCount(CVWorkItem(iitem));
+    cout << " tTotal=" << stopwatch.RealTime() << " residentMemory=" << CVResidentMemory() << endl;
+  }
+  if (fNHashBlocks > -1) cout << "StateHash fileIndex=" << fRunId << " day=" << fLastDayWithPatients << " hash=" << hex << fStateHash << dec << endl;
   cout << "Exposed total: " << fNExposedTotal << "( "<< float(fNExposedTotal)/float(fNPersons) * 100. <<"% of population)" << endl;
 }
 
+void CVMC::RunVariants(int runId, int seed, int nVariants, int runStep, const function<void(int)>& configure) {
+  CVSnapshot snapshot;
+  for(int ivariant = 0; ivariant < nVariants; ivariant++) {
+    configure(ivariant);
+    fRunId = runId + ivariant*runStep;
+    //! every variant starts with the same generator, for the app and reporting draws
+    if(ivariant == 0) {
+      fRandom.SetSeed(seed);
+      fRandomSeed = fRandom.GetSeed();
+      snapshot.seeded = fRandom;
+      fSnapshot = &snapshot;
+    }
+    else fRandom = snapshot.seeded;
+    DoMC(ivariant ? &snapshot : 0);
+  }
+  fSnapshot = 0;
+}
+
+//! the diagnostic histograms that are filled while the days are simulated
+vector<TH1F*> CVMC::GetDiagnosticHistograms() {
+  return { fhIncubationPeriod, fhInfectiousness, fhInfectiousnessAgeNoSymptom, fhInfectiousnessAgeSymptom,
+           fhInfectiousnessDurationSymptom, fhInfectiousnessDurationNoSymptom, fhLatentPeriod,
+           fhDaysToQuarantinePostIntervention, fhDaysToQuarantinePreIntervention, 
+           fhDaysToReportedPostIntervention, fhDaysToReportedPreIntervention,
+           fhDaysToTestedPostIntervention, fhDaysToTestedPreIntervention, fhNumberInfectedPreIntervention };
+}
+
+//! keep the state at the start of .., for the other variants of the run or a checkpoint
+void CVMC::TakeSnapshot(CVSnapshot& s, int day) {
+  s.day = day;
+  s.random = fRandom;
+  //! only the persons something happened to, the others are as after Reset
+  s.persons.clear();
+  for (auto kp : fPersons) {
+    if (kp->GetExposedOn() > -1 || kp->GetNTracedOn() || kp->GetNQuarantinedOn() || kp->GetDayLastTestedOn() > -1) 
+      s.persons.push_back(*kp);
+  }
+  s.inRotation.clear();
+  for (auto kp : fInRotation) s.inRotation.push_back(kp->GetId());
+  s.toErase.clear();
+  for (auto kp : fToErase) s.toErase.push_back(kp->GetId());
+  s.timeOrderedListOfInfectedIDs = fTimeOrderedListOfInfectedIDs;
+  s.totalReported = fTotalReported;
+  s.totalSick     = fTotalSick;
+  s.startTracingOnDay        = fStartTracingOnDay;
+  s.nQuarantine              = fNQuarantine;
+  s.numberRecoveredByDay     = fNumberRecoveredByDay;
+  s.numberInfectiousByDay    = fNumberInfectiousByDay;
+  s.numberNewlyInfectedByDay = numberNewlyInfectedByDay;
+  s.days            = fRunOutput->days;
+  s.summary         = fSummary;
+  s.dailyGrowthRate = fDailyGrowthRate;
+  s.renewal         = fRenewal;
+  TDirectory::TContext context(0); //! the copies belong to no directory
+  s.histograms.clear();
+  for (auto hist : GetDiagnosticHistograms()) s.histograms.emplace_back((TH1*) hist->Clone());
+  s.lastDayWithPatients   = fLastDayWithPatients;
+  s.nSusceptible          = fNSusceptible;
+  s.nRecovered            = fNRecovered;
+  s.dayForROOTTree        = fDayForROOTTree;
+  s.effectiveR            = feffectiveR;
+  s.effectiveRUncertainty = feffectiveRUncertainty;
+  s.nQuarantineToday      = fNQuarantineToday;
+  s.peopleInDotFile       = fPeopleInDotFile;
+  s.lastDayForDot         = fLastDayForDot;
+  s.lastDayForDotSimple   = fLastDayForDotSimple;
+  s.dotStringPeople       = fDotStringPeople;
+  s.dotStringPeopleSimple = fDotStringPeopleSimple;
+}
+
+//! continue from the state of another run, after Reset with the parameters of this one
+void CVMC::RestoreSnapshot(CVSnapshot& s) {
+  //! a checkpoint has the app users and reporters of its run
+  if (s.hasApp.GetSize()) {
+    fHasApp     = s.hasApp;
+    fDoesReport = s.doesReport;
+  }
+  for (auto& person : s.persons) {
+    CVPerson* kp = fPersons.at(person.GetId());
+    *kp = person;
+    //! .. with the app as drawn for this run
+    kp->SetHasApp(fHasApp.Get(kp->GetId()));
+    kp->SetDoesReport(fDoesReport.Get(kp->GetId()));
+  }
+  for (auto id : s.inRotation) fInRotation.push_back(fPersons.at(id));
+  for (auto id : s.toErase)    fToErase.push_back(fPersons.at(id));
+  fTimeOrderedListOfInfectedIDs = s.timeOrderedListOfInfectedIDs;
+  fTotalReported = s.totalReported;
+  fTotalSick     = s.totalSick;
+  fStartTracingOnDay = fStartTestingOnDay = fSocialDistancingFrom = s.startTracingOnDay;
+  fNQuarantine              = s.nQuarantine;
+  fNumberRecoveredByDay     = s.numberRecoveredByDay;
+  fNumberInfectiousByDay    = s.numberInfectiousByDay;
+  numberNewlyInfectedByDay  = s.numberNewlyInfectedByDay;
+  fRunOutput->days = s.days;
+  for (auto& record : fRunOutput->days) record.fileIndex = fRunId;
+  fSummary         = s.summary;
+  fSummary.SetFileIndex(fRunId);
+  fDailyGrowthRate = s.dailyGrowthRate;
+  fRenewal         = s.renewal;
+  vector<TH1F*> histograms = GetDiagnosticHistograms();
+  for (size_t ihist = 0; ihist < histograms.size(); ihist++) {
+    histograms[ihist]->Reset();
+    histograms[ihist]->Add(s.histograms[ihist].get());
+  }
+  fLastDayWithPatients   = s.lastDayWithPatients;
+  fNSusceptible          = s.nSusceptible;
+  fNRecovered            = s.nRecovered;
+  fDayForROOTTree        = s.dayForROOTTree;
+  feffectiveR            = s.effectiveR;
+  feffectiveRUncertainty = s.effectiveRUncertainty;
+  fNQuarantineToday      = s.nQuarantineToday;
+  fPeopleInDotFile       = s.peopleInDotFile;
+  fLastDayForDot         = s.lastDayForDot;
+  fLastDayForDotSimple   = s.lastDayForDotSimple;
+  fDotStringPeople       = s.dotStringPeople;
+  fDotStringPeopleSimple = s.dotStringPeopleSimple;
+  //! record the events and state hashes of the shared days again, for this run
+  for (auto& event : s.events) LogEvent(event.day,CVEventType(event.type),event.person,event.value,event.detail);
+  if (fStateHashInformation) {
+    for (size_t ientry = 0; ientry < s.hashes.size(); ientry++) {
+      fDayForROOTTree = s.hashes[ientry].first;
+      fStateHash      = s.hashes[ientry].second;
+      copy(s.blockHashes.begin()+ientry*fBlockHash.size(),s.blockHashes.begin()+(ientry+1)*fBlockHash.size(),fBlockHash.begin());
+      fStateHashInformation->Fill();
+    }
+    fDayForROOTTree = s.dayForROOTTree;
+  }
+  fRandom   = s.random;
+  fFirstDay = s.day;
+}
+
+//! write the state at the start of .. to the checkpoint file, with the sizes of the output so
+//! far; -1: the run is finished, a resumed job continues with the next one
+void CVMC::WriteCheckpoint(int day) {
+  CVCheckpointHeader header = {};
+  header.run   = fRunId;
+  header.job   = fCheckpointJob;
+  header.point = fPoint;
+  header.day   = day;
+  header.seed  = fRandomSeed;
+  if (fEventLog) fEventLog->Flush();
+  header.eventOffset   = fEventLog ? fEventLog->GetFile()->GetSize() : -1;
+  header.summaryOffset = fSummaryOutput ? int64_t(fSummaryOutput->tellp()) : -1;
+  CVCheckpointWriter out(fCheckpointFilename,header);
+  if (day > -1) {
+    CVSnapshot s;
+    TakeSnapshot(s,day);
+    s.hasApp     = fHasApp;
+    s.doesReport = fDoesReport;
+    //! the state hashes of the days so far, read back from the tree
+    if (fStateHashInformation) {
+      int dayForROOTTree = fDayForROOTTree;
+      ULong64_t stateHash = fStateHash;
+      for (Long64_t ientry = 0; ientry < fStateHashInformation->GetEntries(); ientry++) {
+        fStateHashInformation->GetEntry(ientry);
+        s.hashes.push_back(make_pair(fDayForROOTTree,fStateHash));
+        s.blockHashes.insert(s.blockHashes.end(),fBlockHash.begin(),fBlockHash.end());
+      }
+      fDayForROOTTree = dayForROOTTree;
+      fStateHash      = stateHash;
+    }
+    s.Write(out);
+  }
+  if (!out.Close()) cout << "Error, could not write checkpoint " << fCheckpointFilename << endl;
+}
+
+bool CVMC::Resume(string filename) {
+  CVCheckpointReader in(filename);
+  CVSnapshot snapshot;
+  bool good = in.IsGood() && in.GetHeader().day > -1 
+    && snapshot.Read(in,fNDays,&fRandom,fDisease,GetDiagnosticHistograms()) && snapshot.hasApp.GetSize() == fNPersons
+    && snapshot.blockHashes.size() == snapshot.hashes.size()*(fStateHashInformation ? fBlockHash.size() : 0);
+  if (!good) {
+    cout << "Error, " << (in.IsGood() ? "checkpoint " + filename + " does not fit the simulation" : in.GetError()) << endl;
+    return false;
+  }
+  fRunId      = in.GetHeader().run;
+  fRandomSeed = in.GetHeader().seed;
+  cout << "* resuming run " << fRunId << " on day " << snapshot.day << endl;
+  DoMC(&snapshot);
+  return true;
+}
+
+//! Turn the runtime switches into template arguments one at a time ...
+template<bool... Switches>
+auto CVMC::SelectDayLoop() -> typename enable_if<(sizeof...(Switches) < kNFeatureSwitches)>::type {
+  if (fFeatureSwitches[sizeof...(Switches)]) SelectDayLoop<Switches...,true>();
+  else SelectDayLoop<Switches...,false>();
+}
+//! .. and once all are resolved, run the days with this feature set
+template<bool... Switches>
+auto CVMC::SelectDayLoop() -> typename enable_if<(sizeof...(Switches) == kNFeatureSwitches)>::type {
+  RunDays< CVFeatures<Switches...> >();
+}
+
+template<class F>
+void CVMC::RunDays() {
+  //! Loop over days in the outbreak
+  int iday = fFirstDay;
+  for(; iday < fNDays-1; iday++) {  
+    if (fCheckpointEvery > 0 && iday > fFirstDay && iday%fCheckpointEvery == 0) WriteCheckpoint(iday);
+    //! the variants of the interventions continue from here; the events and hashes were
+    //! collected up to here, the days after are those of the first variant
+    if (fSnapshot && InterventionStarts()) { 
+      TakeSnapshot(*fSnapshot,iday); 
+      fSnapshot = 0;
+    }
+    //! interventions can only act on days after they were started
+    bool sickLeft = iday > fStartTracingOnDay ? DoDay<F,true>(iday) : DoDay<F,false>(iday);
+    if (!sickLeft) break;
+  } //! end of days
+  //! .. or from the end, if the interventions never started
+  if (fSnapshot) {
+    TakeSnapshot(*fSnapshot,iday);
+    fSnapshot = 0;
+  }
+}
+
+//! Simulate one day. Return value is false if no sick people are left.
+template<class F, bool intervention>
+bool CVMC::DoDay(int iday) {
+  //! Infrastructure for .dot output.
+  if (fPeopleInDotFile < fMaxPeopleInDotFile) fLastDayForDot = iday;  
+  if (fPeopleInDotFile < 2.*fMaxPeopleInDotFile) fLastDayForDotSimple = iday;
+  if (iday%50 == 0) cout << "Passed day " << iday << endl;
+  if(F::kDebug) cout << endl << "**** Working on day " << iday << endl;
+  if(F::kTiming) { fTimer.StartDay(); fTimer.Start(P_Census); }
+  fNExposed = 0; fNInfectious = 0; fNTraced = 0; fNReported = 0; fNQuarantineToday=0;  
+    
+  //! remove people who have recovered
+  for(auto kv : fToErase) fInRotation.remove(kv);
+  fToErase.clear();
+  if(fInRotation.size() < 1) { 
+    if (F::kDebug) cout << "No sick people left. Exiting day loop early." << endl; 
+    if (F::kTiming) fTimer.Stop();
+    //! if no one is infected we don't have to keep going
+    return false; 
+  }   
+    
+  int ninfector = 0; //! < Needed for R_e; how many people were sick today?
+  int ninfectee = 0; //! < Needed for R_e; how many people were newly exposed today
+  if (F::kDebug) cout << "Total reported " << fTotalReported << endl;
+  //! Link the start of interventions to the number of reported cases
+  if (InterventionStarts()) { 
+    fStartTracingOnDay = iday; fStartTestingOnDay = iday; fSocialDistancingFrom = iday;
+    if (F::kDebug) cout << "Started tracing, testing, and social distancing on day " << iday << " with " << fTotalReported << "/" << fNPersons  << "=" << float(fTotalReported)/float(fNPersons)<< "  > " << fStartTracingTestingInfectedFraction << endl;
+  }
+  
+  //! iterate on all people who are exposed and not yet recovered
+  for(auto kv : fInRotation) {
+    if(F::kTiming) fTimer.Start(P_Census);
+    //! get current status
+    CVInfectionStatus currentInfectionStatus  = kv->GetInfectionStatus(iday);
+    CVTracingStatus   currentTracingStatus    = kv->GetTracingStatus(iday);
+    bool              currentQuarantineStatus = kv->GetQuarantineStatus(iday);
+    IncrementPopulationStatistics(currentInfectionStatus, currentTracingStatus);
+    //! Do some accounting if person recovered today
+    if(currentInfectionStatus == S_Recovered) { 
+      if(F::kDebug) fPeopleInDotFile++;
+      //! use them to calcualte R_e (we can't do it sooner as only here they have infected everyone they could have)
+      ninfector++;
+      ninfectee = ninfectee + kv->GetNExposed();
+      FillDiagnostics(kv, intervention || iday == fStartTestingOnDay);
+      //! add to remove pile
+      fToErase.push_back(kv); 
+      continue;  
+    }
+    
+    //! find new victims if infectious
+    if((currentInfectionStatus == S_ExposedInfectious || currentInfectionStatus == S_Infectious) 
+      //! .. but not quarantined
+      && currentQuarantineStatus == false) {
+      if(F::kTiming) fTimer.Start(P_Infection);
+      fRandom.SetStream(R_Contacts,kv->GetId(),iday);
+      //! get todays infectiousness
+      float infProb = kv->GetDisease()->GetInfectiousness(iday-kv->GetSymptomOnset(),kv->GetHasSymptoms());
+      //! .. and the number of constacts
+      int meettoday = GetPeopleMetToday(iday);
+      //! draw number of victims
+      int ninfected = fRandom.Binomial(meettoday,infProb); 
+      if(F::kTiming) fTimer.Count(W_InfectionAttempts,ninfected);
+      //! .. and remember how many people we met and did not infect (so we know how many to trace)
+      kv->AddUninfectedContacts(iday, meettoday-ninfected);
+      //! Now infect the victims ...
+      for(int iinfect = ninfected; iinfect--;) {
+        //! randomly pick the victim's ID
+        int pp = fRandom.Integer(fNPersons);
+        //! .. but not ourselves
+        if (pp == kv->GetId()) pp = (pp+1)%fNPersons;
+        //! only infect the person if not infected before and not in quarantine
+        if(fPersons.at(pp)->GetExposedOn()<0 && !fPersons.at(pp)->GetQuarantineStatus(iday)) {
+          LogEvent(iday,E_Exposure,pp,kv->GetId());
+          if (F::kDebug) AddConnectionToDot(kv->GetId(), pp, 0, iday);
+          fTimeOrderedListOfInfectedIDs.push_back(pp); 
+          fRenewal.AddGenerationInterval(iday-kv->GetExposedOn());
+          //! the course of the disease comes from the stream of the victim
+          CVCommonRandom::State contacts = fRandom.GetState();
+          fRandom.SetStream(R_Course,pp);
+          fPersons.at(pp)->Expose(iday,kv);
+          fRandom.SetState(contacts);
+          fTotalSick++;
+          fInRotation.push_back(fPersons.at(pp));
+    } } }
+    
+    //! see if we can report a person .. only if not already reported
+    if(kv->GetReportedOn()<0) {
+      if(F::kTiming) fTimer.Start(P_Reporting);
+      fRandom.SetStream(R_Tests,kv->GetId(),iday);
+      bool doesReport = false;
+      int reportday = iday;
+      CVReportReason reason = R_Symptoms;
+      //! .. if showing symptoms and person willing to see doctor/has access to test
+      if(currentInfectionStatus == S_Infectious && kv->GetHasSymptoms() && fDoesReport.Get(kv->GetId())) { 
+        doesReport = true; 
+      }
+      //! .. or if traced and then tested positive
+      if(intervention && currentTracingStatus == S_Traced) { 
+        //! get days since the most recent time we got traced
+        int daysSinceTraced = iday - kv->GetTracedOn(kv->GetNTracedOn()-1);
+        //! .. and tested
+        int daysSinceTested = kv->GetDayLastTestedOn() > -1 ? iday - kv->GetDayLastTestedOn() : 9999;          
+        //! if tracing is recent (today or yesterday) and no test was performed ...
+        if(daysSinceTraced <=1 && daysSinceTested > 2) {
+          //! .. test them
+          bool positive = kv->GetTestsPositive(iday);
+          LogEvent(iday,E_Test,kv->GetId(),positive,R_Traced);
+          if(positive) { 
+            doesReport = true; 
+            //! .. but wait for the test result
+            reportday=reportday+fDaysToTestResult;
+            reason = R_Traced;
+        } }
+        //! .. or re-test after some time in quarantine, this should cover the latent period
+        else if (daysSinceTested == fdTTest) { 
+          bool positive = kv->GetTestsPositive(iday);
+          LogEvent(iday,E_Test,kv->GetId(),positive,R_Retest);
+          if (positive) { 
+            doesReport = true; 
+            reportday=reportday+fDaysToTestResult;
+            reason = R_Retest;
+          }
+          //! .. if this turns out negative, release the person
+          else {
+            int released = kv->ReleaseFromQuarantine(iday+fDaysToTestResult,fDaysInQuarantine);
+            LogEvent(iday+fDaysToTestResult,E_Release,kv->GetId(),released);
+      } } }
+      //! .. or if selected for a random test
+      else if(F::kRandomTesting && intervention && fRandom.Uniform() < fRandomTestingRate) {
+        //! .. that is performed once
+        bool positive = kv->GetTestsPositive(iday);
+        LogEvent(iday,E_Test,kv->GetId(),positive,R_RandomTest);
+        if(positive) {
+          doesReport = true; 
+          reportday=reportday+fDaysToTestResult;  
+          reason = R_RandomTest;
+      } }        
+      if(doesReport) {
+        LogEvent(iday,E_Report,kv->GetId(),reportday,reason);
+        if(F::kTiming) fTimer.Count(W_Quarantines);
+        int quarantinedTo = kv->Report(reportday,fDaysInQuarantine); 
+        LogEvent(reportday,E_Quarantine,kv->GetId(),quarantinedTo-reportday,reason);
+        fTotalReported++;
+    } } 
+
+    //! reporting triggers tracing of
+    if (intervention && kv->GetReportedOn()+fTracingDelay == iday && fHasApp.Get(kv->GetId())) {
+      if(F::kTiming) fTimer.Start(P_Tracing);
+      fRandom.SetStream(R_Tracing,kv->GetId(),iday);
+      //! .. contacts you infected
+      for(auto kvv : kv->GetExposed()) {
+          Trace<F>(fPersons.at(kvv),iday,kv->GetId(),1);
+      } 
+      //! .. the contact you got infected from (unless you are patient 0)
+      if(F::kBackwardTracing && kv->GetInfectedBy() >= 0) { 
+        Trace<F>(fPersons.at(kv->GetInfectedBy()),iday,kv->GetId(),2);  
+      }
+      //! .. and a bunch of people you may have met but not infected
+      TraceUninfected<F>(kv,iday);        
+    } 
+             
+  } //! end of sick people on this day
+  // check who is in quarantine
+  if(F::kTiming) fTimer.Start(P_Quarantine);
+  if(fNHashBlocks < 0) { for (auto qkv : fPersons) { if (qkv->GetQuarantineStatus(iday)) fNQuarantineToday++; } }
+  else HashDay(iday); //! .. and hash the state while passing the population anyway
+  //! figure out R_t. 
+  if(F::kTiming) fTimer.Start(P_Output);
+  fNumberRecoveredByDay.push_back(ninfector);
+  fNumberInfectiousByDay.push_back(fNInfectious);
+  numberNewlyInfectedByDay.push_back(ninfectee);
+  AddDayToTSVAndROOT(iday);
+  if(fNHashBlocks > -1) {
+    fStateHashInformation->Fill();
+    if(fSnapshot) {
+      fSnapshot->hashes.push_back(make_pair(iday,fStateHash));
+      fSnapshot->blockHashes.insert(fSnapshot->blockHashes.end(),fBlockHash.begin(),fBlockHash.end());
+  } }
+  fLastDayWithPatients = iday;
+  if(F::kTiming) { fTimer.EndDay(); fPerformanceInformation->Fill(); }
+  return true;
+}
+
+template<class F>
 void CVMC::TraceUninfected(CVPerson *aperson, int day) {
-  if (!fTraceUninfected) { return; }
-  if(aperson->GetHasApp() == 0) { return; }
+  if (!F::kTraceUninfected) { return; }
+  if(!fHasApp.Get(aperson->GetId())) { return; }
   for (int iday = max(0, day - fDaysBackwardTrace); iday <= day; iday++) { // loop over days in the backward trace
     int pplMet = aperson->GetUninfectedContactsDay(iday);
     if (pplMet < 0) { //! We have not yet drawn how many people we meet today, so do it now
@@ -264,19 +540,24 @@ void CVMC::TraceUninfected(CVPerson *aperson, int day) {
       //! .. but not ourselves
       if (pp == aperson->GetId()) pp = (pp+1)%fNPersons;
       //! we did not really meet this person because they were in Q on that day, or the trace is unsuccessful because the contact doesn't have the app
-      if (fPersons.at(pp)->GetQuarantineStatus(iday) || fPersons.at(pp)->GetHasApp() == 0) continue;
+      if (fPersons.at(pp)->GetQuarantineStatus(iday) || !fHasApp.Get(pp)) continue;
       //! WARNING: instead of the usuall quarantine time uninfected contacts enter 
       //! for the time until the second test, this emulates 100% test efficiency and no false positives
       //! and disregards the possibility that the person was infected by someone else in the meantime.
-      fPersons.at(pp)->Quarantine(day,fdTTest); // Note: People sent to quarantine will ignore the order if they have previously been reported (ie they know they've been infected and recovered already)
+      if (F::kTiming) fTimer.Count(W_Quarantines);
+      int quarantinedTo = fPersons.at(pp)->Quarantine(day,fdTTest); // Note: People sent to quarantine will ignore the order if they have previously been reported (ie they know they've been infected and recovered already)
+      LogEvent(day,E_Quarantine,pp,quarantinedTo-day,R_Contact);
     }
   }
 }
             
 //! Helper function for Trace. Return value is whether or not we did the trace
+template<class F>
 bool CVMC::DoTrace(CVPerson *aperson, int day, int fromPersonID, int tlevel, int direction) {
-  if (aperson->GetHasApp() == 0 || fPersons.at(fromPersonID)->GetHasApp() == 0) {
-    AddConnectionToDot(fromPersonID, aperson->GetId(),98,day);
+  if (F::kTiming) fTimer.Count(W_Traces);
+  if (!fHasApp.Get(aperson->GetId()) || !fHasApp.Get(fromPersonID)) {
+    LogEvent(day,E_Trace,aperson->GetId(),fromPersonID,98);
+    if (F::kDebug) AddConnectionToDot(fromPersonID, aperson->GetId(),98,day);
     return false;
   }
   //! figure out if person has been reported before today
@@ -295,19 +576,21 @@ bool CVMC::DoTrace(CVPerson *aperson, int day, int fromPersonID, int tlevel, int
 
   //! contact too far in the past to be traced
   if(contactDifference > fDaysBackwardTrace) { 
-    AddConnectionToDot(fromPersonID, aperson->GetId(),99,day); 
+    LogEvent(day,E_Trace,aperson->GetId(),fromPersonID,99);
+    if (F::kDebug) AddConnectionToDot(fromPersonID, aperson->GetId(),99,day); 
     return false; 
   }
   //! figure out if we miss the contact by chance
   if(fRandom.Uniform() > fTracingEfficiency) {
-    AddConnectionToDot(fromPersonID, aperson->GetId(),98,day);
+    LogEvent(day,E_Trace,aperson->GetId(),fromPersonID,98);
+    if (F::kDebug) AddConnectionToDot(fromPersonID, aperson->GetId(),98,day);
     return false;
   }
   //! Set the tracing status
   bool traced = aperson->Trace(day, day+fDaysInQuarantine); // they keep 'traced' status as long as one might be in quarantine
-  if (traced) { 
-    AddConnectionToDot(fromPersonID, aperson->GetId(),tlevel,day);
-    if (fDebug) cout << "Dotrace: traced person " << aperson->GetId() << "from person " << fromPersonID << endl;
+  if (traced) {
+    LogEvent(day,E_Trace,aperson->GetId(),fromPersonID,tlevel);
+    if (F::kDebug) AddConnectionToDot(fromPersonID, aperson->GetId(),tlevel,day);
   }
   return traced;
 }
@@ -315,34 +598,31 @@ bool CVMC::DoTrace(CVPerson *aperson, int day, int fromPersonID, int tlevel, int
 //! 'aperson' is someone who was exposed by a person whose contacts we start tracing on day 'day'
 //! we trace only if 'aperson' was exposed at most setting.daysBackwardTrace days before 'day'
 //! Direction=1 : forward trace; direction=2: backward trace
+template<class F>
 void CVMC::Trace(CVPerson *aperson, int day, int fromPersonID, int direction) {
-  if (direction == 2 && !fBackwardTracing) return;
-  if(DoTrace(aperson, day, fromPersonID, 1, direction)) { 
-   aperson->Quarantine(day,fDaysInQuarantine); //! if we traced, we also quarantine
+  if (direction == 2 && !F::kBackwardTracing) return;
+  if(DoTrace<F>(aperson, day, fromPersonID, 1, direction)) { 
+   QuarantineTraced<F>(aperson,day); //! if we traced, we also quarantine
   }
   else return; //! we did not trace this person, so we don't trace 2nd order from them
   
-  if (fTracingOrder < 2) return; //! we also don't trace 2nd order if that is turned off in settings
-  else if (fTracingOrder > 2 || fTracingOrder < 1) { 
-    cout << "Trace:Parameter error: tracingOrder must be 1 or 2; is currently " << fTracingOrder << endl; 
-    return; 
-  }
+  if (!F::kSecondOrderTracing) return; //! we also don't trace 2nd order if that is turned off in settings
   //! We confirmed that we trace 2nd order contacts now
   //! If we're on a backward trace, continue to back-trace infector
   //! If we are on a forward trace, this is not necessary as the infector is the original index case
-  if (direction==2 && fBackwardTracing && aperson->GetInfectedBy() >=0)  {
-    if (DoTrace( fPersons.at(aperson->GetInfectedBy()) , day, aperson->GetId(), 2, 2) ) {
-      fPersons.at(aperson->GetInfectedBy())->Quarantine(day,fDaysInQuarantine); 
+  if (direction==2 && F::kBackwardTracing && aperson->GetInfectedBy() >=0)  {
+    if (DoTrace<F>( fPersons.at(aperson->GetInfectedBy()) , day, aperson->GetId(), 2, 2) ) {
+      QuarantineTraced<F>(fPersons.at(aperson->GetInfectedBy()),day); 
     }
   }
   //! For the second order trace, aperson is now the index case. Therefore, trace their uninfected contacts ...
-  TraceUninfected(aperson,day);
+  TraceUninfected<F>(aperson,day);
   //! And their remaining contacts
   for (int iexp = 0; iexp < aperson->GetNExposed(); iexp++) {
     if (aperson->GetExposedPersonID(iexp) == fromPersonID) { continue; } //! if this is coming from a backward trace, we don't want to go back -> forth -> back
     CVPerson *pExp2ndOrder = fPersons.at(aperson->GetExposedPersonID(iexp));
-    if (DoTrace(pExp2ndOrder, day, aperson->GetId(), 2, 1)) {
-      pExp2ndOrder->Quarantine(day,fDaysInQuarantine);
+    if (DoTrace<F>(pExp2ndOrder, day, aperson->GetId(), 2, 1)) {
+      QuarantineTraced<F>(pExp2ndOrder,day);
     }
   }  
 }//trace end
@@ -393,6 +673,29 @@ void CVMC::FillDiagnostics(CVPerson *kv, bool posttracing) {
    }
 
 }
+//! Count the people in quarantine and roll the state of the population into the state hash
+void CVMC::HashDay(int day) {
+  int nblocks = fBlockHash.size();
+  fill(fBlockHash.begin(), fBlockHash.end(), 0);
+  //! block iblock holds the persons [iblock*fNPersons/nblocks, (iblock+1)*fNPersons/nblocks)
+  int iblock = 0;
+  long blockEnd = long(fNPersons)/nblocks;
+  for (int ip = 0; ip < fNPersons; ip++) {
+    while (ip >= blockEnd) blockEnd = long(++iblock+1)*fNPersons/nblocks;
+    CVPerson* person = fPersons[ip];
+    if (person->GetQuarantineStatus(day)) fNQuarantineToday++;
+    //! the app only acts once the interventions started, and the variants of a run draw it
+    //! differently, so the days they share before have the same hashes in all of them
+    fBlockHash[iblock] = CVHashCombine(fBlockHash[iblock], CVHashPerson(ip, person, day, day >= fStartTracingOnDay && fHasApp.Get(ip)));
+  }
+  //! the day, the population counters and the blocks, on top of all previous days
+  fStateHash = CVHashCombine(fStateHash, day);
+  int counters[] = { fNExposed, fNInfectious, fNRecovered, fNTraced, fNReported, fNQuarantineToday, 
+                     fTotalReported, fTotalSick, int(fInRotation.size()), fStartTracingOnDay };
+  for (int counter : counters) fStateHash = CVHashCombine(fStateHash, uint32_t(counter));
+  for (auto block : fBlockHash) fStateHash = CVHashCombine(fStateHash, block);
+}
+
 //******* DOT output *******/
 void CVMC::AddPersonToDot(CVPerson *kv) {
   if (fPeopleInDotFile > 2.*fMaxPeopleInDotFile) { return; }
@@ -556,7 +859,6 @@ void CVMC::AddConnectionToDot(int IDfrom, int IDto, int tlevel, int tday) {
     fDotStringPeopleSimple = Form("%s \t %d -> %d [%s penwidth=%d] \n",fDotStringPeopleSimple.c_str(),IDfrom, IDto,DotOptions.c_str(),penwidth); // don't add missed connections to simple output
     if (fPeopleInDotFile >= fMaxPeopleInDotFile) fDotStringPeople = Form("%s \t %d -> %d [%s penwidth=%d] \n",fDotStringPeople.c_str(),IDfrom, IDto,DotOptions.c_str(),penwidth); // don't add missed connections to reduced output
     }
-  if (fDebug) { cout<<"\t " << IDfrom << " -> " << IDto << Form(" [%s]", DotOptions.c_str()) << endl;  }
 }
 
 void CVMC::AddDaysToDot() {
@@ -608,7 +910,8 @@ void CVMC::AddHeaderToTSV() {
   */
   fOutputTSV<< "# (1) day (2) nSusceptible  (3) nExposed  (4) nInfectious  (5) nRecovered  \
                (6) nTraced+nReported  (7) nQuarantine  (8) R_eff (5 day average)  (9)  \
-                R_eff uncertainty  (10) doubling time  (11) doubling time uncertainty" << endl;
+                R_eff uncertainty  (10) doubling time  (11) doubling time uncertainty  \
+                (12) R_t (renewal equation)  (13) R_t uncertainty" << endl;
 }
 
 void CVMC::IncrementPopulationStatistics(CVInfectionStatus is, CVTracingStatus ts) {
@@ -628,31 +931,23 @@ void CVMC::IncrementPopulationStatistics(CVInfectionStatus is, CVTracingStatus t
 
 
 void CVMC::AddDayToTSVAndROOT(int day) {
+  int newlyExposed = (day == 0 ? fNPersons : fNSusceptible) - (fNPersons - fNExposed - fNRecovered - fNInfectious);
   fNSusceptible = fNPersons - fNExposed - fNRecovered - fNInfectious;
   int ninfector = fNumberRecoveredByDay.at(day); int ninfectee = numberNewlyInfectedByDay.at(day);
    feffectiveR = -99.0; feffectiveRUncertainty = 0.;
   
-  // calculate the doubling time
-  float doublingTime = -99., doublingTimeUncertainty = -99.; //! Days needed to double number of new infections  
-  float doublingDay = -99.;
-  float doublingDayUncertainty = -99.0;
-  // take the average of last 2 days to minimize fluctuations
-  if (day > 4) {
-    float lin_a, lin_m; // y = a + m*x   
-    float dlin_a, dlin_m; // uncertainties. Use sqrt(y) for y as uncertainty
-    int infectedTodayYesterday = float(ninfectee + fNumberRecoveredByDay.at(day-1))/2.0;
-    int infected2to4daysAgo = float(fNumberRecoveredByDay.at(day-2) + fNumberRecoveredByDay.at(day-3))/2.0;
-    lin_m = infectedTodayYesterday - infected2to4daysAgo;
-    dlin_m = sqrt(infectedTodayYesterday+infected2to4daysAgo); // (x2-x1) = 1, hence m = (y2-y1)/(x2-x1) = (y2-y1)
-    lin_a = infectedTodayYesterday - lin_m  * (day-0.5);
-    dlin_a = sqrt(infectedTodayYesterday + TMath::Power(float(day)*dlin_m,2)    );
-    if (abs(lin_m) > 0.005) {
-    doublingDay = (2.*infectedTodayYesterday - lin_a )/lin_m;
-    doublingDayUncertainty = sqrt(  TMath::Power(2./lin_m,2)*infectedTodayYesterday + TMath::Power(dlin_a/lin_m, 2) + TMath::Power( dlin_m*(2.*infectedTodayYesterday - lin_a)/(lin_m*lin_m) , 2)  );
+  //! Days needed to double the number of new exposures, fitted over the last days
+  float doublingTime = -99., doublingTimeUncertainty = -99.;
+  if (fDebug) {
+    fDailyGrowthRate.AddDay(day, newlyExposed);
+    if (fDailyGrowthRate.GetDoublingTime() != CVGrowthRate::kNoEstimate) {
+      doublingTime = fDailyGrowthRate.GetDoublingTime();
+      doublingTimeUncertainty = fDailyGrowthRate.GetDoublingTimeUncertainty();
     }
   }
-  if ( doublingDay>0) doublingTime = doublingDay - day;
-  if ( doublingDay>0) doublingTimeUncertainty = abs( doublingTime - (doublingDay+doublingDayUncertainty -day) );
+
+  //! real-time R from the new exposures and the generation intervals so far
+  fRenewal.AddDay(newlyExposed);
 
   if (ninfector > 0) {
     feffectiveR = float(ninfectee)/float(ninfector);
@@ -665,12 +960,16 @@ void CVMC::AddDayToTSVAndROOT(int day) {
   if (fDebug) fOutputTSV << day << "\t" << fNSusceptible << "\t" << fNExposed << "\t" << fNInfectious 
                     << "\t" <<  fNRecovered << "\t" << fNTraced+fNReported << "\t" 
                     << fNQuarantine.at(day) << "\t" << feffectiveR << "\t" << feffectiveRUncertainty 
-                    << "\t" << doublingTime << "\t" << doublingTimeUncertainty << endl;
+                    << "\t" << doublingTime << "\t" << doublingTimeUncertainty
+                    << "\t" << fRenewal.GetR() << "\t" << fRenewal.GetRUncertainty() << endl;
   if (fDebug) cout << day << "\t" << fNSusceptible << "\t" << fNExposed << "\t" << fNInfectious 
                     << "\t" <<  fNRecovered << "\t" << fNTraced+fNReported << "\t" 
                     << fNQuarantine.at(day) << "\t" << feffectiveR << "\t" << feffectiveRUncertainty << "\t" << doublingTime << endl;
   fDayForROOTTree = day;
-  fPopulationLevelInformation->Fill();
+  CVDayRecord record = { fRunId, day, fNSusceptible, fNExposed, fNInfectious, fNRecovered, fNTraced, fNReported,
+                        feffectiveR, feffectiveRUncertainty, fRenewal.GetR(), fRenewal.GetRUncertainty(), fNQuarantineToday };
+  fSummary.AddDay(record,fStartTestingOnDay);
+  if (!fSummaryOutput || fBands) fRunOutput->days.push_back(record);
                       
 }
  
@@ -688,6 +987,7 @@ void CVMC::WriteGnuplotScript() {
   fOutputGnuplot << "# (5) nRecovered \t , nTraced+nReported , (7) nQuarantine , " << endl;
   fOutputGnuplot << "# (8) R_eff (10 day average) , (9) R_eff uncertainty" << endl;
   fOutputGnuplot << "# (10) doubling time , (11) doubling time uncertainty" << endl;
+  fOutputGnuplot << "# (12) R_t (renewal equation) , (13) R_t uncertainty" << endl;
 
   fOutputGnuplot << "set key bottom right" << endl;
   fOutputGnuplot << "set grid" << endl;
@@ -736,11 +1036,13 @@ void CVMC::WriteGnuplotScript() {
   fOutputGnuplot << Form("set xrange [1:%d]",fitto+50) << endl;
   try { fOutputGnuplot << Form("set yrange [0:%.3f]",fNumberInfectiousByDay.at(fitto+10)*1.5) << endl; }
   catch (...) { fOutputGnuplot << Form("set yrange [0:%.3f]",fNumberInfectiousByDay.at(fitto)*1.5) << endl; }
+  //! exponential fitted to the infectious in [fitfrom, fitto]
+  CVGrowthRate growth(0,0);
+  for (int iday = fitfrom; iday <= fitto; iday++) growth.AddDay(iday, fNumberInfectiousByDay.at(iday));
   fOutputGnuplot << "f(x, l, a) = a*exp(x*log(2)/l)" << endl;
-  fOutputGnuplot << "l = 5" << endl;
-  fOutputGnuplot << "a = 17.5" << endl;
+  fOutputGnuplot << Form("l = %g", growth.GetDoublingTime()) << endl;
+  fOutputGnuplot << Form("a = %g", growth.GetDoublingTime() == CVGrowthRate::kNoEstimate ? 0. : growth.GetAmplitude(0)) << endl;
   fOutputGnuplot << "set ylabel \"People\"" << endl;
-  fOutputGnuplot << Form("fit [%d:%d] f(x,l,a) \"CovidMCResult_%d.txt\" using 1:4 via l,a", fitfrom, fitto, fRunId) << endl;
   fOutputGnuplot << "ti = sprintf(\"T2 = %.2f\", l)" << endl;
   fOutputGnuplot << Form("plot \"CovidMCResult_%d.txt\"  using 1:4 w l lc 4 title \"Infected\", \\", fRunId) << endl;
   fOutputGnuplot << Form("     (x > %d && x < %d) ? f(x,l,a) : 1/0 lc 3 lw 2 title ti",fitfrom, fitto)<< endl;
@@ -748,27 +1050,88 @@ void CVMC::WriteGnuplotScript() {
 }
 
 
+CVRunSummary& CVMC::GetRunSummary() {
+  CVRunSummary& summary = fSummary.GetSummary();
+  summary.randomSeed          = fRandomSeed;
+  summary.lastDayWithPatients = fLastDayWithPatients;
+  return summary;
+}
+
+//! One json line with the key settings and the outcome of the run, e.g. for sweep drivers
+void CVMC::WriteSummary() {
+  CVRunSummary& summary = GetRunSummary();
+  nlohmann::json record;
+  //! floats with the digits they have, not those of the double they are stored as
+  auto Float = [](float value) { return stod(Form("%.7g",value)); };
+  record["fileIndex"]            = summary.fileIndex;
+  record["randomSeed"]           = summary.randomSeed;
+  record["point"]                = fPoint;
+  //! settings
+  record["nPersons"]             = fNPersons;
+  record["nDays"]                = fNDays;
+  record["peopleMetPerDay"]      = Float(fPeopleMetPerDay);
+  record["daysInQuarantine"]     = fDaysInQuarantine;
+  record["tracingOrder"]         = fTracingOrder;
+  record["startTracingTestingInfectedFraction"] = Float(fStartTracingTestingInfectedFraction);
+  record["AppProbability"]       = Float(fAppProbability);
+  record["ReportingProbability"] = Float(fReportingProbability);
+  record["tracingEfficiency"]    = Float(fTracingEfficiency);
+  record["TracingDelay"]         = fTracingDelay;
+  record["daysToTestResult"]     = fDaysToTestResult;
+  record["randomTestingRate"]    = Float(fRandomTesting ? fRandomTestingRate : 0.f);
+  record["SocialDistancingFactor"]  = Float(fSocialDistancingFactor);
+  record["symptomProbability"]      = Float(fDisease->GetSymptomProbability());
+  record["transmissionProbability"] = Float(fDisease->GetTransmissionProbability());
+  //! outcome
+  record["LastDayWithPatients"]  = summary.lastDayWithPatients;
+  record["startTestingOnDay"]    = summary.startTestingOnDay;
+  record["maxDailySick"]         = summary.maxDailySick;
+  record["maxQuarantine"]        = summary.maxQuarantine;
+  record["maxTotalSick"]         = summary.maxTotalSick;
+  record["sickByDay365"]         = summary.sickByDay365;
+  record["QuarantineManDays"]    = Float(summary.quarantineManDays);
+  record["averageRe"]            = Float(summary.averageRe);
+  record["nRe"]                  = summary.nRe;
+  record["averageRePre"]         = Float(summary.averageRePre);
+  record["nRePre"]               = summary.nRePre;
+  record["doublingTime"]         = Float(summary.doublingTime);
+  record["doublingTimeUncertainty"] = Float(summary.doublingTimeUncertainty);
+  record["outbreak"]             = summary.outbreak;
+  //! one line at a time from the simulations that share the output
+  static mutex writing;
+  lock_guard<mutex> lock(writing);
+  *fSummaryOutput << record.dump() << endl;
+}
+
+//! Diagnostic canvas with the drawn and the input distributions
+void CVMC::DrawDiagnostics() {
+  TGraph* tcc = 0;
+  TCanvas* tc = CVDrawDiagnostics(fDisease,fhIncubationPeriod,fhInfectiousness,fhLatentPeriod,&tcc);
+  if (fDebug) tc->SaveAs(Form("diagnostic%s_%d.pdf",fOutputPrefix.c_str(),fRunId));
+  fRunOutput->AddObject(tc);
+  fRunOutput->AddObject(tcc);
+}
+
 void CVMC::WriteROOTFile() {
-  fOutputRoot->cd();  
   fhIncubationPeriod->SetLineColor(1);
   fhInfectiousness->SetLineColor(kBlue);
   fhLatentPeriod->SetLineColor(kRed);
   fhIncubationPeriod->Scale(1.0/fhIncubationPeriod->Integral());
-  fhIncubationPeriod->Write();
+  fRunOutput->AddHistogram(fhIncubationPeriod);
   fhInfectiousness->Scale(fDisease->GetInfectiousness()->Integral(-2,20)/fhInfectiousness->Integral()); // turn into probability
-  fhInfectiousness->Write();
+  fRunOutput->AddHistogram(fhInfectiousness);
   fhLatentPeriod->Scale(1.0/fhLatentPeriod->Integral());
-  fhLatentPeriod->Write();
+  fRunOutput->AddHistogram(fhLatentPeriod);
   fhInfectiousnessAgeSymptom->Scale(1.0/fhInfectiousnessAgeSymptom->Integral());
-  fhInfectiousnessAgeSymptom->Write();
+  fRunOutput->AddHistogram(fhInfectiousnessAgeSymptom);
   fhInfectiousnessAgeNoSymptom->Scale(1.0/fhInfectiousnessAgeNoSymptom->Integral());
-  fhInfectiousnessAgeNoSymptom->Write();
+  fRunOutput->AddHistogram(fhInfectiousnessAgeNoSymptom);
   
   fhInfectiousnessDurationNoSymptom->Scale(1.0/fhInfectiousnessDurationNoSymptom->Integral());
   fhInfectiousnessDurationSymptom->Scale(1.0/fhInfectiousnessDurationSymptom->Integral());
     
-  fhInfectiousnessDurationSymptom->Write();
-  fhInfectiousnessDurationNoSymptom->Write();
+  fRunOutput->AddHistogram(fhInfectiousnessDurationSymptom);
+  fRunOutput->AddHistogram(fhInfectiousnessDurationNoSymptom);
   
   fhDaysToQuarantinePostIntervention->Scale(1.0/float(fNExposedTotal));
   fhDaysToQuarantinePreIntervention->Scale(1.0/float(fNExposedTotal));
@@ -777,67 +1140,33 @@ void CVMC::WriteROOTFile() {
   fhDaysToTestedPostIntervention->Scale(1.0/float(fNExposedTotal));  
   fhDaysToTestedPreIntervention->Scale(1.0/float(fNExposedTotal));
           
-  fhDaysToQuarantinePostIntervention->Write();
-  fhDaysToQuarantinePreIntervention->Write();  
+  fRunOutput->AddHistogram(fhDaysToQuarantinePostIntervention);
+  fRunOutput->AddHistogram(fhDaysToQuarantinePreIntervention);  
   
-  fhDaysToReportedPostIntervention->Write();  
-  fhDaysToReportedPreIntervention->Write();
+  fRunOutput->AddHistogram(fhDaysToReportedPostIntervention);  
+  fRunOutput->AddHistogram(fhDaysToReportedPreIntervention);
   
-  fhDaysToTestedPostIntervention->Write();      
-  fhDaysToTestedPreIntervention->Write();   
-  fhNumberInfectedPreIntervention->Write();     
+  fRunOutput->AddHistogram(fhDaysToTestedPostIntervention);      
+  fRunOutput->AddHistogram(fhDaysToTestedPreIntervention);   
+  fRunOutput->AddHistogram(fhNumberInfectedPreIntervention);     
   
-  gStyle->SetOptStat(0);
-  gStyle->SetOptTitle(0);  
-  TCanvas *tc =new TCanvas("tc","tc");
-  TH1F *hdummy = new TH1F("hdummy",";day;probability",33,-3,30);
-  hdummy->Draw();
-  hdummy->GetYaxis()->SetRangeUser(0.0, 1.0);
-    // Draw the test positive probability
-  float xvals[40];
-  float yvals[40];
-  int xycount = 0;
-  for (int iday = -3; iday < 30; iday++) {
-    xvals[xycount] = iday;
-    yvals[xycount] = fDisease->GetTestPositiveProb(iday);
-      xycount++;
-  }
-  TGraph *tcc  = new TGraph(xycount, &xvals[0], &yvals[0]);
-  tcc->SetMarkerStyle(2);
-  tcc->SetLineColor(1);
-  tcc->SetName("TestPositiveProb");
-  tcc->Write();
-  tcc->Draw("ALPsame");
-  
-  fDisease->GetIncubationPeriod()->SetLineColor(kGray);
-  fhIncubationPeriod->Draw("same");
-  fDisease->GetIncubationPeriod()->Draw("same");
-  fDisease->GetInfectiousness()->SetLineColor(kBlue-2);
-
-  fhInfectiousness->SetLineWidth(2);
-  
-
-
-  fDisease->GetInfectiousness()->Draw("same");
-  fhInfectiousness->Draw("same");
-  fhLatentPeriod->Draw("same");
-  TLegend *fl = new TLegend();
-  fl->AddEntry(fhIncubationPeriod, "Incubation Period" , "l");
-  fl->AddEntry(fhInfectiousness, "Infectiousness relative to symptom start" , "l");
-  fl->AddEntry(fhLatentPeriod, "Latent Period" , "l");
-  fl->AddEntry(tcc, "Test positive probability" , "lp");      
-  makeLegend(fl, tc, 1);
-  fl->Draw();
-  tc->Modified();
-  tc->Update();  
-  if (fDebug) tc->SaveAs(Form("diagnostic%s_%d.pdf",fOutputPrefix.c_str(),fRunId));
-  tc->Write();
-  fPopulationLevelInformation->Write();
+  //! the canvas is the same for all runs in a file, so it is only drawn once unless we make pdfs,
+  //! and not at all without graphics (plotCVMC draws it from the histograms)
+  if (!fHeadless && (fDebug || !fOutputRoot->HasObject("tc"))) {
+    //! graphics are not thread safe
+    static mutex drawing;
+    lock_guard<mutex> lock(drawing);
+    DrawDiagnostics();
+  }
+  if (fTiming) fRunOutput->AddTree(fPerformanceInformation);
+  if (fStateHashInformation) fRunOutput->AddTree(fStateHashInformation);
   
-  //
-  TTree* settings = new TTree("settings","");
+  //! settings and outcome of the run, copied into the run output
+  unique_ptr<TTree> settings(new TTree("settings",""));
+  settings->SetDirectory(0);
   settings->Branch("index",&fRunId);
   settings->Branch("randomSeed",&fRandomSeed);
+  settings->Branch("point",&fPoint);
   settings->Branch("nPersons",&fNPersons);
   settings->Branch("nDays",   &fNDays);
   settings->Branch("LastDayWithPatients", &fLastDayWithPatients);
@@ -910,103 +1239,38 @@ void CVMC::WriteROOTFile() {
   settings->Branch("R00",  &R00);
   settings->Branch("R0e",  &R0e);  
 
+  //! one row with the outcome of the run
+  CVRunSummary& summary = GetRunSummary();
+  unique_ptr<TTree> runSummary(new TTree("runSummary","CV MC outcome per run"));
+  runSummary->SetDirectory(0);
+  runSummary->Branch("fileIndex",          &summary.fileIndex);
+  runSummary->Branch("randomSeed",         &summary.randomSeed);
+  runSummary->Branch("point",              &fPoint);
+  runSummary->Branch("LastDayWithPatients",&summary.lastDayWithPatients);
+  runSummary->Branch("startTestingOnDay",  &summary.startTestingOnDay);
+  runSummary->Branch("maxDailySick",       &summary.maxDailySick);
+  runSummary->Branch("maxQuarantine",      &summary.maxQuarantine);
+  runSummary->Branch("maxTotalSick",       &summary.maxTotalSick);
+  runSummary->Branch("sickByDay365",       &summary.sickByDay365);
+  runSummary->Branch("QuarantineManDays",  &summary.quarantineManDays);
+  runSummary->Branch("averageRe",          &summary.averageRe);
+  runSummary->Branch("nRe",                &summary.nRe);
+  runSummary->Branch("averageRePre",       &summary.averageRePre);
+  runSummary->Branch("nRePre",             &summary.nRePre);
+  runSummary->Branch("doublingTime",       &summary.doublingTime);
+  runSummary->Branch("doublingTimeUncertainty", &summary.doublingTimeUncertainty);
+  runSummary->Branch("outbreak",           &summary.outbreak);
+  runSummary->Fill();
+  fRunOutput->AddTree(runSummary.get());
+
+  //! memory use [kB] at the end of the run, constant over a job unless something leaks
+  int residentMemory     = CVResidentMemory();
+  int peakResidentMemory = CVPeakResidentMemory();
+  settings->Branch("residentMemory",    &residentMemory);
+  settings->Branch("peakResidentMemory",&peakResidentMemory);
   settings->Fill();
-  settings->Write();  
-    
-  fOutputRoot->Close();  
+  fRunOutput->AddTree(settings.get());
+  //! hand the run to the writer
+  fOutputRoot->AddRun(fRunOutput);
+  fRunOutput = 0;
 }
-
-// because ROOT can't make a decent legend automatically
-void CVMC::makeLegend(TLegend *ll, TPad *pad, int location)
-{
-  if (!pad || !ll) {
-    cout << "Cannet make legend dimensions without pad or legend pointer. Please use makeDSLegend(legend, pad)." << endl;
-    return;
-  }
-  pad->cd();
-
-  // hardcoded constants that determine the size and spacing of legend entries
-  int legendTextSize = gStyle->GetLabelSize() - 2; //px
-  float legendSampleLength = 0.3; // length of sample lines as fraction of legend width
-  int legendEntryPadding = 2; // vertical padding between entries
-  int gapBetweenSampleAndLabel = 15; // px  horizontal distance between the sample line and the label
-
-  // get some info about pad size and legend rows; this is used to figure out the dimensions of the legend box
-  int padHeightinPx = gPad->VtoPixel(0);
-  int padWidthinPx = gPad->UtoPixel(1);
-  int legendRowsN = ll->GetNRows(); // how many entries are in this legend
-
-  // utility variables to store legend data we need to determine legend dimensions
-  TLegendEntry* entry;  // a pointer to each entry
-  int longestLabel = 0;  // count how long the labels are
-  string legendHeader = ""; // is there a header?
-  gStyle->SetLegendFont(gStyle->GetLegendFont());
-  ll->SetTextAlign(12);
-  ll->SetTextSize(legendTextSize);
-  ll->SetMargin(legendSampleLength); // length of sample lines as fraction of legend width
-
-  // I guess legends are exempt from the general gStyle rules ...
-  ll->SetBorderSize(0);
-  ll->SetFillColor(kWhite);
-  ll->SetFillStyle(1001);
-
-  // determine height
-  float legendHeight = float((legendRowsN * (legendTextSize + 2*legendEntryPadding)))/float(padHeightinPx);
-  // determine width based on number of characters in labels
-
-  if (ll->GetHeader()) legendHeader = ll->GetHeader();
-  int iLegendRow = (legendHeader.size() < 2 ? 0 : 1) ;  // if there is a header, we skip it in the loop
-  for (; iLegendRow < ll->GetNRows(); iLegendRow++) {  // i = 0:  header, if there is one
-    entry = (TLegendEntry*)ll->GetListOfPrimitives()->At(iLegendRow);
-    string labelText = entry->GetLabel();
-    if ((int)labelText.size() > longestLabel) {
-      longestLabel = labelText.size();
-    }
-  }
-
-  // determine width
-
-  // average width of text = (number of chars) * (size in px)/(font constant)
-  // font constant = 2.24 for Helvetica
-  float legendTextWidth = longestLabel * legendTextSize/2.24;
-  float legendWidth = legendTextWidth * (1 + legendSampleLength) + gapBetweenSampleAndLabel;
-  float titleWidth = legendHeader.size()* legendTextSize/2.24;
-  if (legendWidth < titleWidth) { // we cut off the title if the box isn't big enough
-    legendSampleLength = (titleWidth - legendTextWidth - gapBetweenSampleAndLabel)/titleWidth; // make samples longer so they aren't so far away from their labels
-    ll->SetMargin(legendSampleLength);
-    legendWidth = titleWidth;
-  }
-
-  legendWidth = float(legendWidth)/float(padWidthinPx);
-
-  /*** legend location ***/
-  switch (location) {
-    case 0:   // top right corner aligned with histogram top right corner
-      ll->SetY2NDC(1. - gPad->GetTopMargin() - 0.02);
-      ll->SetX2NDC(1 - gPad->GetRightMargin() - 0.02);
-      ll->SetY1NDC(ll->GetY2NDC() - legendHeight);
-      ll->SetX1NDC(ll->GetX2NDC() - legendWidth);
-      break;
-    case 1: // bottom right
-      ll->SetX2NDC(1 - gPad->GetRightMargin() - 0.02);
-      ll->SetY1NDC(gPad->GetBottomMargin() + 0.02);
-
-      ll->SetY2NDC(ll->GetY1NDC() + legendHeight);
-      ll->SetX1NDC(ll->GetX2NDC() - legendWidth);
-      break;
-
-    case 2: // top left
-      ll->SetY2NDC(1. - gPad->GetTopMargin() - 0.02);
-      ll->SetX1NDC(gPad->GetLeftMargin() + 0.02);
-      ll->SetX2NDC(ll->GetX1NDC() + legendWidth);
-      ll->SetY1NDC(ll->GetY2NDC() - legendHeight);
-      break;
-    case 3: // bottom left
-      ll->SetY1NDC(gPad->GetBottomMargin() + 0.02);
-      ll->SetX1NDC(gPad->GetLeftMargin() + 0.02);
-      ll->SetX2NDC(ll->GetX1NDC() + legendWidth);
-      ll->SetY2NDC(ll->GetY1NDC() + legendHeight);
-      break;
-  }
-  ll->Draw();
-}  
@@ -31,9 +31,12 @@ DEALINGS IN THE SOFTWARE.
 //c++
 #include <list>
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <type_traits>
+#include <functional>
 
 //root
 #include <TRandom3.h>
@@ -43,16 +46,36 @@ DEALINGS IN THE SOFTWARE.
 #include <TTree.h>
 #include <TH1F.h>
 #include <TGraph.h>
-#include <TCanvas.h>
-#include <TLegend.h>
-#include <TLegendEntry.h>
-#include <TStyle.h>
-#include <TPad.h>
 #include "CVDisease.h"
+#include "CVDiagnostics.h"
 #include "CVPerson.h"
+#include "CVBitColumn.h"
+#include "CVEventLog.h"
+#include "CVPhaseTimer.h"
+#include "CVStateHash.h"
+#include "CVOutput.h"
+#include "CVRunSummary.h"
+#include "CVGrowthRate.h"
+#include "CVReproductionNumber.h"
+#include "CVEnsembleBands.h"
+#include "CVCommonRandom.h"
+#include "CVSnapshot.h"
 
 using namespace std;
 
+//! switches of the day loop that are fixed for a whole run. DoMC selects the matching
+//! instantiation once, so the loop over people carries no checks for them.
+template<bool debug, bool randomTesting, bool backwardTracing, bool traceUninfected, bool secondOrderTracing, bool timing>
+struct CVFeatures 
+{
+  static const bool kDebug              = debug;              //! verbose output and dot file
+  static const bool kRandomTesting      = randomTesting;      //! random tests after interventions start
+  static const bool kBackwardTracing    = backwardTracing;    //! also trace who infected a reported person
+  static const bool kTraceUninfected    = traceUninfected;    //! also quarantine uninfected contacts
+  static const bool kSecondOrderTracing = secondOrderTracing; //! tracing order 2
+  static const bool kTiming             = timing;             //! time the phases of each day
+};
+
 class CVMC 
 {
   public:
@@ -62,6 +85,8 @@ class CVMC
       //! general
       fMaxPeopleInDotFile = 400;
       fDebug = false;      
+      fTiming = false;
+      fHeadless = false;
       //! default parameters
       fPeopleMetPerDay           =  11;
       fSocialDistancingMaxPeople =  10;
@@ -92,8 +117,11 @@ class CVMC
       fPeopleMetFunctionDistancing->SetRange(0,fSocialDistancingMaxPeople);      
       //! make the people 
       for(int i=0;i<fNPersons;i++) 
-        fPersons.push_back(new CVPerson(fNDays,&fRandom));
+        fPersons.push_back(new CVPerson(i,fNDays,&fRandom));
       if(fDebug) cout << "* made " << fPersons.size() << " people" << endl;  
+      //! .. and their per-run attribute columns
+      fHasApp.Resize(fNPersons);
+      fDoesReport.Resize(fNPersons);
       //! ... and the disease
       fDisease = new CVDisease(&fRandom); 
       //! vector to store qurantine stats   
@@ -114,25 +142,42 @@ class CVMC
       fhDaysToTestedPreIntervention      = new TH1F("fhDaysToTestedPreIntervention","; (day tested - day exposed) [day]",32,-2,30);    
       fhNumberInfectedPreIntervention      = new TH1F("fhNumberInfectedPreIntervention","; number of infectees",60,0,60);    
           
-      //! link output tree branches
-      fPopulationLevelInformation = new TTree("PopulationLevelInformation","CV MC");
-      fPopulationLevelInformation->Branch("fileIndex",&fRunId);            
-      fPopulationLevelInformation->Branch("day",&fDayForROOTTree);
-      fPopulationLevelInformation->Branch("fNSusceptible",&fNSusceptible);
-      fPopulationLevelInformation->Branch("fNExposed",&fNExposed);
-      fPopulationLevelInformation->Branch("fNInfectious",&fNInfectious);
-      fPopulationLevelInformation->Branch("fNRecovered",&fNRecovered);
-      fPopulationLevelInformation->Branch("fNTraced",&fNTraced);
-      fPopulationLevelInformation->Branch("fNReported",&fNReported);
-      fPopulationLevelInformation->Branch("feffectiveR",&feffectiveR);
-      fPopulationLevelInformation->Branch("feffectiveRUncertainty",&feffectiveRUncertainty);
-      fPopulationLevelInformation->Branch("fNQuarantineToday",&fNQuarantineToday);  
+      //! the optional performance tree
+      fPerformanceInformation = new TTree("PerformanceInformation","CV MC phase timing [us] and work per day");
+      fPerformanceInformation->Branch("fileIndex",&fRunId);            
+      fPerformanceInformation->Branch("day",&fDayForROOTTree);
+      for(int iphase = 0; iphase < Phase_COUNT; iphase++) 
+        fPerformanceInformation->Branch(Form("t%s",kCVPhaseNames[iphase]),fTimer.GetDayTime(CVPhase(iphase)));
+      for(int iitem = 0; iitem < Work_COUNT; iitem++) 
+        fPerformanceInformation->Branch(Form("n%s",kCVWorkItemNames[iitem]),fTimer.GetDayCount(CVWorkItem(iitem)));
     }
     ~CVMC() {
       //! delete the people
       for(auto kv : fPersons) delete kv;
       //! ... and the disease
       delete fDisease;  
+      //! ... and hand the last events to the file
+      delete fEventLog;
+      delete fRunOutput;
+      //! ... and the functions, histograms and trees
+      delete fPeopleMetFunction;
+      delete fPeopleMetFunctionDistancing;
+      delete fhIncubationPeriod;
+      delete fhInfectiousness;
+      delete fhInfectiousnessAgeNoSymptom;
+      delete fhInfectiousnessAgeSymptom;
+      delete fhInfectiousnessDurationSymptom;
+      delete fhInfectiousnessDurationNoSymptom;
+      delete fhLatentPeriod;
+      delete fhDaysToQuarantinePostIntervention;
+      delete fhDaysToQuarantinePreIntervention;
+      delete fhDaysToReportedPostIntervention;
+      delete fhDaysToReportedPreIntervention;
+      delete fhDaysToTestedPostIntervention;
+      delete fhDaysToTestedPreIntervention;
+      delete fhNumberInfectedPreIntervention;
+      delete fPerformanceInformation;
+      delete fStateHashInformation;
     }
       
     //! getters
@@ -151,8 +196,8 @@ class CVMC
     TF1*   GetPeopleMetFunction()           { return fPeopleMetFunction;           }
     TF1*   GetPeopleMetFunctionDistancing() { return fPeopleMetFunctionDistancing; }    
     int    GetPeopleMetToday(int day=0)     {
-      if(day >= fSocialDistancingFrom && day < fSocialDistancingTo) return (int) fPeopleMetFunctionDistancing->GetRandom(); 
-      return (int) fPeopleMetFunction->GetRandom();
+      if(day >= fSocialDistancingFrom && day < fSocialDistancingTo) return (int) fPeopleMetFunctionDistancing->GetRandom(&fRandom); 
+      return (int) fPeopleMetFunction->GetRandom(&fRandom);
     }
     
     int    GetTracingOrder()           { return fTracingOrder;      }       
@@ -172,6 +217,13 @@ class CVMC
     vector<CVPerson*> GetPersons()     { return fPersons; }   
     
     //! setters
+    void SetAppProbability(float appProb)       { fAppProbability = appProb;       }
+    void SetReportingProbability(float repProb) { fReportingProbability = repProb; }
+    //! tag the runs with the point of a parameter sweep
+    void SetPoint(int point) { fPoint = point; }
+    //! draw the random numbers of every person and day from their own streams, so that runs with
+    //! the same seed and different interventions see the same contacts, courses and attributes
+    void SetCommonRandomNumbers(bool common=true) { fRandom.SetCommon(common); }
     void SetPeopleMetPerDay(int peopleMetPerDay) { 
       fPeopleMetPerDay = peopleMetPerDay; 
       fPeopleMetFunction->SetParameter(0,fPeopleMetPerDay); 
@@ -204,29 +256,79 @@ class CVMC
     void SetRandomTestingRate(float randomTestingRate) { fRandomTestingRate = randomTestingRate; }
     
     void SetDebug(bool debug=true)                     { fDebug=debug;                           }
+    void SetTiming(bool timing=true)                   { fTiming=timing;                         }
+    void SetHeadless(bool headless=true)               { fHeadless=headless;                     }
     void SetMaxPeopleInDotFile(int maxPeopleInDotFile) { fMaxPeopleInDotFile=maxPeopleInDotFile; }
+    //! record individual events into .. (not owned, may be shared with other simulations); 0 switches recording off
+    void SetEventFile(CVEventFile* eventFile) { 
+      delete fEventLog; 
+      fEventLog = eventFile ? new CVEventLog(eventFile) : 0; 
+    }
+    //! write all runs into .. (not owned, may be shared with other simulations); 0 writes one file per run
+    void SetOutput(CVOutput* output) { fOutput = output; }
+    //! write only a json line with the settings and outcome of every run to .. (not owned), no root output; 0 switches back
+    void SetSummaryOutput(ostream* summaryOutput) { fSummaryOutput = summaryOutput; }
+    //! add the daily census of every run to the ensemble bands .. (not owned); 0 switches off
+    void SetBands(CVEnsembleBands* bands) { fBands = bands; }
+    //! hash the population state each day, per person in .. blocks (0=only the whole population); -1 switches hashing off
+    void SetStateHashing(int nblocks) {
+      fNHashBlocks = nblocks < 0 ? -1 : min(nblocks,fNPersons);
+      delete fStateHashInformation;
+      fStateHashInformation = 0;
+      if(fNHashBlocks < 0) return;
+      fBlockHash.assign(max(fNHashBlocks,1),0);
+      fStateHashInformation = new TTree("StateHash","CV MC rolling state hash per day");
+      fStateHashInformation->Branch("fileIndex",&fRunId);
+      fStateHashInformation->Branch("day",&fDayForROOTTree);
+      fStateHashInformation->Branch("hash",&fStateHash);
+      fStateHashInformation->Branch("nBlocks",&fNHashBlocks);
+      if(fNHashBlocks > 0) fStateHashInformation->Branch("blockHash",&fBlockHash[0],Form("blockHash[%d]/l",fNHashBlocks));
+    }
     
     //! run mc with id .. and seed ..
     void Run(int runId=0,int seed=0) {
       fRunId = runId;
       fRandom.SetSeed(seed);
       fRandomSeed = fRandom.GetSeed();
-      gRandom->SetSeed(fRandom.Integer(4294967295)); //! for TF1::GetRandom
-      //! reset all counters etc.
-      Reset();
-      //! .. and run it
+      //! reset all counters etc. and run it
       DoMC();
     }      
+    //! run .. variants of the interventions on the same outbreak, as runs runId, runId+runStep, ..
+    //! with seed ..; configure(ivariant) sets the parameters of a variant, which may only differ
+    //! in what acts after the interventions start. The days before are simulated once, with the
+    //! first variant, and the others continue from a snapshot of the day the interventions start.
+    void RunVariants(int runId, int seed, int nVariants, int runStep, const function<void(int)>& configure);
+    //! write a checkpoint of the run to .. at the start of every ..th day and when the run is
+    //! finished, tagged with the job ..; 0 days switches checkpoints off
+    void SetCheckpoint(string filename, int everyDays, uint64_t job=0) {
+      fCheckpointFilename = filename;
+      fCheckpointEvery    = everyDays;
+      fCheckpointJob      = job;
+    }
+    //! continue the run of the checkpoint .. from its day, with the parameters set as for the
+    //! run and the output up to the checkpoint kept; false if the checkpoint does not fit
+    bool Resume(string filename);
   
   protected:
     void Reset() {
+      //! roll out the app and decide who reports, drawn in blocks of 64 persons
+      fRandom.SetStream(R_AppUsers);
+      fHasApp.Draw(&fRandom,fAppProbability);
+      fRandom.SetStream(R_Reporters);
+      fDoesReport.Draw(&fRandom,fReportingProbability);
       //! reset the population
       for(auto kv : fPersons) {
         kv->Reset(); 
-        //! ... and roll out the app
-        if(fRandom.Uniform()<fAppProbability) kv->SetHasApp();
-        if(fRandom.Uniform()<fReportingProbability) kv->SetDoesReport(); 
+        //! ... and keep the persons in sync for the dot output and external users
+        kv->SetHasApp(fHasApp.Get(kv->GetId()));
+        kv->SetDoesReport(fDoesReport.Get(kv->GetId()));
       }
+      //! reset people stacks
+      fInRotation.clear();
+      fToErase.clear();
+      fTimeOrderedListOfInfectedIDs.clear();
+      fTotalReported = 0;
+      fTotalSick     = 0;
       //! reset population statistics
       fNExposed    = 0;
       fNInfectious = 0;
@@ -236,12 +338,22 @@ class CVMC
       fStartTracingOnDay = 99999;
       fStartTestingOnDay = 99999;
       fSocialDistancingFrom = 99999;
+      fFirstDay = 0;
       fill(fNQuarantine.begin(), fNQuarantine.end(), 0);      
       fNumberRecoveredByDay.clear();
       fNumberInfectiousByDay.clear();
       numberNewlyInfectedByDay.clear();      
-      //! reset output tree
-      fPopulationLevelInformation->Reset();       
+      //! reset output trees
+      delete fRunOutput;
+      fRunOutput = new CVRunOutput();
+      //! .. and the summary
+      fSummary.Reset(fRunId,fNPersons,CVSummaryAccumulator::GetOutbreakThreshold(fStartTracingTestingInfectedFraction,fNPersons));
+      fDailyGrowthRate.Reset();
+      fRenewal.Reset();
+      fPerformanceInformation->Reset();
+      fTimer.Reset();
+      fStateHash = 0;
+      if(fStateHashInformation) fStateHashInformation->Reset();
       //! reset histograms  
       fhInfectiousnessAgeSymptom->Reset();
       fhInfectiousnessAgeNoSymptom->Reset();
@@ -272,10 +384,23 @@ class CVMC
       fNQuarantineToday      = 0;     
     }
     
-    void DoMC();
-    void Trace(CVPerson* aperson,int day,int fromPersonID, int direction);
-    bool DoTrace(CVPerson* aperson,int day,int fromPersonID, int tlevel, int direction);
-    void TraceUninfected(CVPerson* aperson,int day);
+    void DoMC(CVSnapshot* from=0);
+    void TakeSnapshot(CVSnapshot& snapshot, int day);
+    void RestoreSnapshot(CVSnapshot& snapshot);
+    vector<TH1F*> GetDiagnosticHistograms();
+    void WriteCheckpoint(int day);
+    //! the interventions start once more than this fraction of the population got sick
+    bool InterventionStarts() {
+      return float(fTotalSick)/float(fNPersons) > fStartTracingTestingInfectedFraction && fStartTracingOnDay > 9998;
+    }
+    static const int kNFeatureSwitches = 6;
+    template<bool... Switches> typename enable_if<(sizeof...(Switches) <  kNFeatureSwitches)>::type SelectDayLoop();
+    template<bool... Switches> typename enable_if<(sizeof...(Switches) == kNFeatureSwitches)>::type SelectDayLoop();
+    template<class F> void RunDays();
+    template<class F, bool intervention> bool DoDay(int day);
+    template<class F> void Trace(CVPerson* aperson,int day,int fromPersonID, int direction);
+    template<class F> bool DoTrace(CVPerson* aperson,int day,int fromPersonID, int tlevel, int direction);
+    template<class F> void TraceUninfected(CVPerson* aperson,int day);
     void TraceBack(int id,int day,int fromPersonID);    
     void AddPersonToDot(CVPerson *kv);
     void AddConnectionToDot(int IDfrom, int IDto, int tlevel=0, int tday=-1);
@@ -286,14 +411,32 @@ class CVMC
     void IncrementPopulationStatistics(CVInfectionStatus is, CVTracingStatus ts);
     void AddDayToTSVAndROOT(int day);
     void WriteROOTFile();
-    void makeLegend(TLegend *ll, TPad *pad, int location=0); // I need this to stay sane
+    void WriteSummary();
+    CVRunSummary& GetRunSummary();
+    void DrawDiagnostics();
     void FillDiagnostics(CVPerson *kv, bool posttracing);
+    void HashDay(int day);
+    void LogEvent(int day, CVEventType type, int person, int value=0, int detail=0) {
+      if(!fEventLog) return;
+      fEventLog->Record(fRunId,day,type,person,value,detail);
+      //! .. and keep the events of the days the variants share
+      if(fSnapshot) fSnapshot->events.push_back({fRunId,int16_t(day),type,uint8_t(detail),person,value});
+    }
+    template<class F> void QuarantineTraced(CVPerson* aperson, int day) {
+      if(F::kTiming) fTimer.Count(W_Quarantines);
+      int quarantinedTo = aperson->Quarantine(day,fDaysInQuarantine);
+      LogEvent(day,E_Quarantine,aperson->GetId(),quarantinedTo-day,R_Traced);
+    }
     
   private:
-    TRandom3 fRandom = TRandom3(0);
+    CVCommonRandom fRandom = CVCommonRandom(0);
     unsigned int fRandomSeed;
     bool  fDebug;
+    bool  fTiming;  //! time the phases of each day
+    bool  fHeadless; //! no canvases or other graphics objects, only histograms and trees
+    bool  fFeatureSwitches[kNFeatureSwitches]; //! CVFeatures template arguments of the current run
     int   fRunId = -1;
+    int   fPoint = 0;    //! point of the parameter sweep the runs belong to
     
     int   fNPersons;
     int   fNDays;
@@ -325,6 +468,18 @@ class CVMC
     TF1*  fPeopleMetFunctionDistancing; //! .. under social distancing 
     CVDisease*        fDisease; //! this is the disease
     vector<CVPerson*> fPersons; //! this will hold every person in the population 
+    list<CVPerson*>   fInRotation; //! people who are exposed and not yet recovered
+    list<CVPerson*>   fToErase;    //! people who have recovered and should be removed before the next day
+    vector<int>       fTimeOrderedListOfInfectedIDs; //! People are added here sorted by day they were infected; this is used in the dot output chart
+    int               fTotalReported; //! cumulative number of reported people
+    int               fTotalSick;     //! cumulative number of exposed people
+    int               fFirstDay;      //! the day the run starts with, after the days taken from a snapshot
+    CVSnapshot*       fSnapshot = 0;  //! taken when the interventions start, 0 if not needed or already taken
+    string            fCheckpointFilename;
+    int               fCheckpointEvery = 0; //! days between checkpoints, 0 if none are written
+    uint64_t          fCheckpointJob = 0;   //! tag of the job in the checkpoints
+    CVBitColumn       fHasApp;     //! bit per person: uses the tracing app in this run
+    CVBitColumn       fDoesReport; //! bit per person: goes to the doctor when symptomatic in this run
     
     //! Output and gathering of statistics 
     string fOutputPrefix;
@@ -340,8 +495,12 @@ class CVMC
     string fDotStringLegend;
     ofstream fOutputGnuplot;
     
+    CVEventLog* fEventLog = 0; //! binary record of individual events, 0 if not recorded
     ofstream fOutputTSV;   //! Tab separated file
-    TFile *fOutputRoot;    //! Root output file    
+    CVOutput *fOutput = 0; //! Root output shared by all runs, 0 if one file per run
+    CVOutput *fOutputRoot; //! Root output of this run
+    ostream  *fSummaryOutput = 0; //! summary-only output
+    CVEnsembleBands *fBands = 0;  //! bands of the daily census over all runs, 0 if not made
     //! diagnostic output histograms
     TH1F *fhIncubationPeriod;
     TH1F *fhInfectiousness;
@@ -358,7 +517,16 @@ class CVMC
     TH1F *fhDaysToTestedPreIntervention;
     TH1F *fhNumberInfectedPreIntervention;
         
-    TTree *fPopulationLevelInformation;
+    CVRunOutput *fRunOutput = 0;    //! day records and copies of the trees and histograms of this run, until handed to the output
+    TTree *fPerformanceInformation; //! per-day phase timing, written if fTiming
+    CVPhaseTimer fTimer;
+    CVSummaryAccumulator fSummary; //! outcome of the run, written to the runSummary tree
+    CVGrowthRate fDailyGrowthRate = CVGrowthRate(14); //! of the new exposures in the last two weeks, for the debug output
+    CVRenewalEstimator fRenewal;   //! real-time R of the last week, written next to the effective R
+    int        fNHashBlocks = -1;            //! blocks of persons hashed separately, -1 if not hashing
+    ULong64_t  fStateHash;                   //! rolling hash of the state over all days so far
+    vector<ULong64_t> fBlockHash;            //! hash of the persons in each block today
+    TTree     *fStateHashInformation = 0;    //! per-day state hashes, written if hashing
     // R_e and doubling time
     vector<int> fNumberRecoveredByDay;  //! number of people who recovered on each day
     vector<int> fNumberInfectiousByDay; //! number of people who are infectioues on each day
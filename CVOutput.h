@@ -0,0 +1,247 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Single output file for all runs of a job, written by a dedicated thread. Each simulation
+ * collects the output of a run (the day records of the PopulationLevelInformation tree,
+ * copies of the other trees and of the diagnostic histograms) in a CVRunOutput and hands it
+ * over through a bounded queue, so it never waits for compression or disk unless the writer
+ * falls more than a few runs behind. The writer appends the trees of every run to the trees
+ * of the same name, sums the histograms and writes run-independent objects once, the same
+ * content that hadd used to produce from per-run files. Optionally the day records are also
+ * written to a root-independent column file (see CVColumnFile.h).
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVOutput_H
+#define CVOutput_H
+
+//! c++
+#include <map>
+#include <set>
+#include <deque>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+//! root
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1.h>
+
+#include "CVColumnFile.h"
+
+using namespace std;
+
+//! everything a run writes, owned by this object until the writer is done with it
+class CVRunOutput
+{
+  public:
+    ~CVRunOutput() {
+      for(auto tree : trees)      delete tree;
+      for(auto hist : histograms) delete hist;
+      for(auto object : objects)  delete object;
+    }
+    //! copies are taken, so .. can be reset for the next run right away
+    void AddTree(TTree* tree) {
+      TDirectory::TContext context(0); //! the copy belongs to no directory
+      TTree* copy = tree->CloneTree();
+      copy->ResetBranchAddresses();    //! .. and reads into its own buffers, not into those of ..
+      trees.push_back(copy);
+    }
+    void AddHistogram(TH1* histogram) {
+      TDirectory::TContext context(0);
+      histograms.push_back((TH1*) histogram->Clone());
+    }
+    //! objects that are the same in every run, taken over and only written for the first run
+    void AddObject(TObject* object) { objects.push_back(object); }
+
+    vector<CVDayRecord> days;
+    vector<TTree*>      trees;
+    vector<TH1*>        histograms;
+    vector<TObject*>    objects;
+};
+
+class CVOutput
+{
+  public:
+    //! at most .. runs wait in the queue before AddRun blocks
+    //! (the caller enables the thread safety of root before, as the file is written by a thread)
+    CVOutput(string filename, int queueSize=4) : fFilename(filename), fQueueSize(queueSize) {
+      {
+        TDirectory::TContext context; //! the file does not become the current directory of the caller
+        fFile = new TFile(filename.c_str(),"recreate");
+      }
+      fPopulationLevelInformation = 0;
+      fColumns = 0;
+      fDone = false;
+      if(IsOpen()) fWriter = thread(&CVOutput::Write, this);
+    }
+    ~CVOutput() { 
+      Close(); 
+      delete fFile; 
+      delete fColumns;
+    }
+
+    bool   IsOpen()      { return fFile && fFile->IsOpen(); }
+    string GetFilename() { return fFilename; }
+    //! also write the day records of every run to the column file .., call before the first AddRun
+    bool SetColumnFile(string filename) {
+      fColumns = new CVColumnWriter(filename);
+      return fColumns->IsOpen();
+    }
+    //! true if an object of this name was already handed over, so it need not be made again
+    bool HasObject(string name) {
+      lock_guard<mutex> lock(fMutex);
+      return fObjects.count(name);
+    }
+
+    //! hand over the output of a run, waits while the queue is full
+    void AddRun(CVRunOutput* run) {
+      unique_lock<mutex> lock(fMutex);
+      //! drop the run-independent objects we already have
+      for(auto& object : run->objects) {
+        if(fObjects.insert(object->GetName()).second) continue;
+        delete object;
+        object = 0;
+      }
+      run->objects.erase(remove(run->objects.begin(),run->objects.end(),(TObject*) 0),run->objects.end());
+      fNotFull.wait(lock, [this] { return (int) fQueue.size() < fQueueSize; });
+      fQueue.push_back(run);
+      fNotEmpty.notify_one();
+    }
+
+    //! write what is queued, then the sums and trees, and close the file
+    void Close() {
+      if(!fWriter.joinable()) return;
+      {
+        lock_guard<mutex> lock(fMutex);
+        fDone = true;
+      }
+      fNotEmpty.notify_one();
+      fWriter.join();
+      if(fColumns) fColumns->Close();
+      fFile->cd();
+      for(auto kv : fHistograms) kv.second->Write();
+      for(auto kv : fTrees)      kv.second->Write();
+      fFile->Close();
+      for(auto kv : fHistograms) delete kv.second;
+      fHistograms.clear();
+      fTrees.clear(); //! owned by the file
+      for(auto object : fWritten) delete object;
+      fWritten.clear();
+    }
+
+  private:
+    //! the writer thread
+    void Write() {
+      fFile->cd();
+      while(true) {
+        CVRunOutput* run;
+        {
+          unique_lock<mutex> lock(fMutex);
+          fNotEmpty.wait(lock, [this] { return fDone || !fQueue.empty(); });
+          if(fQueue.empty()) return;
+          run = fQueue.front();
+          fQueue.pop_front();
+        }
+        fNotFull.notify_one();
+        WriteRun(run);
+        delete run;
+      }
+    }
+    void WriteRun(CVRunOutput* run) {
+      //! day records
+      if(!fPopulationLevelInformation) {
+        fPopulationLevelInformation = new TTree("PopulationLevelInformation","CV MC");
+        fPopulationLevelInformation->SetDirectory(fFile);
+        fPopulationLevelInformation->Branch("fileIndex",&fDay.fileIndex);            
+        fPopulationLevelInformation->Branch("day",&fDay.day);
+        fPopulationLevelInformation->Branch("fNSusceptible",&fDay.nSusceptible);
+        fPopulationLevelInformation->Branch("fNExposed",&fDay.nExposed);
+        fPopulationLevelInformation->Branch("fNInfectious",&fDay.nInfectious);
+        fPopulationLevelInformation->Branch("fNRecovered",&fDay.nRecovered);
+        fPopulationLevelInformation->Branch("fNTraced",&fDay.nTraced);
+        fPopulationLevelInformation->Branch("fNReported",&fDay.nReported);
+        fPopulationLevelInformation->Branch("feffectiveR",&fDay.effectiveR);
+        fPopulationLevelInformation->Branch("feffectiveRUncertainty",&fDay.effectiveRUncertainty);
+        fPopulationLevelInformation->Branch("fRt",&fDay.Rt);
+        fPopulationLevelInformation->Branch("fRtUncertainty",&fDay.RtUncertainty);
+        fPopulationLevelInformation->Branch("fNQuarantineToday",&fDay.nQuarantineToday);  
+        fTrees[fPopulationLevelInformation->GetName()] = fPopulationLevelInformation;
+      }
+      for(auto& day : run->days) {
+        fDay = day;
+        fPopulationLevelInformation->Fill();
+      }
+      if(fColumns && !run->days.empty()) fColumns->WriteRun(run->days[0].fileIndex,run->days);
+      //! other trees, appended to the tree of the same name
+      for(auto tree : run->trees) {
+        TTree*& merged = fTrees[tree->GetName()];
+        if(!merged) {
+          merged = tree->CloneTree(0);
+          merged->SetDirectory(fFile);
+        }
+        else tree->CopyAddresses(merged);
+        for(Long64_t ientry = 0; ientry < tree->GetEntries(); ientry++) {
+          tree->GetEntry(ientry);
+          merged->Fill();
+        }
+      }
+      //! histograms, summed
+      for(auto& histogram : run->histograms) {
+        TH1*& sum = fHistograms[histogram->GetName()];
+        if(sum) sum->Add(histogram);
+        else {
+          sum = histogram; 
+          histogram = 0; //! kept as the sum
+      } }
+      //! objects, only present for the first run
+      for(auto object : run->objects) {
+        object->Write();
+        fWritten.push_back(object);
+      }
+      run->objects.clear();
+    }
+
+    string fFilename;
+    TFile* fFile;
+    int    fQueueSize;
+    thread fWriter;
+    mutex  fMutex;                  //! guards the queue and fObjects
+    condition_variable fNotEmpty;
+    condition_variable fNotFull;
+    deque<CVRunOutput*> fQueue;     //! runs waiting to be written
+    bool   fDone;                   //! no more runs will be added
+    set<string> fObjects;           //! names of the objects handed over
+    //! only used by the writer thread
+    CVDayRecord        fDay;        //! branch buffer of the PopulationLevelInformation tree
+    TTree*             fPopulationLevelInformation;
+    CVColumnWriter*    fColumns;    //! column file of the day records, optional
+    map<string,TTree*> fTrees;      //! merged trees, attached to the file
+    map<string,TH1*>   fHistograms; //! summed histograms
+    vector<TObject*>   fWritten;    //! objects written, deleted on close
+};
+
+#endif
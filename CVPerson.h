@@ -31,6 +31,7 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 
 #include "CVDisease.h"
+#include "CVCheckpoint.h"
 
 using namespace std;
 
@@ -46,12 +47,11 @@ enum CVTracingStatus : uint8_t {
 class CVPerson 
 {
   public:
-    //! construct and pass global random number generator
-    CVPerson(int days,TRandom3* random) : fRandom(random) {
+    //! construct with id (the index in the population) and pass global random number generator
+    CVPerson(int id,int days,TRandom3* random) : fRandom(random) {
       //! keep track if intialized with internal generator
       fInternalRandom = false;
-      //! automatic unique id
-      fId = nextId++;
+      fId = id;
       //! max lifetime
       fNDays = days;
       //! status containers
@@ -61,9 +61,9 @@ class CVPerson
       //! reset the persons memory
       Reset(); //! -> happens anyhow before MC run
     }
-    //! construct with internal random number generator
+    //! construct with automatic unique id and internal random number generator
     CVPerson(int days=100) 
-      : CVPerson(days,new TRandom3(0)) {
+      : CVPerson(nextId++,days,new TRandom3(0)) {
       //! .. and keep track that intialized with internal generator
       fInternalRandom = true;
     }
@@ -299,6 +299,44 @@ class CVPerson
       return Quarantine(day,quarantine);
     }
 
+    //! checkpoint of what happened to the person (see CVCheckpoint.h); the disease is the
+    //! one of the population, given on reading
+    void Write(CVCheckpointWriter& out) const {
+      out.Write(fId);
+      int days[] = { fExposedOn, fInfectiousOn, fSymptomOnset, fReportedOn, fRecoveredOn, fDayLastTestedOn, fInfectedBy };
+      out.Write(days);
+      bool flags[] = { fHasSymptoms, fHasApp, fDoesReport };
+      out.Write(flags);
+      out.Write(fQuarantinedOn);
+      out.Write(fTracedOn);
+      out.WriteRuns(fInfectionStatus);
+      out.WriteRuns(fTracingStatus);
+      out.WriteRuns(fQuarantineStatus);
+      out.Write(fExposed);
+      out.Write(fDays);
+      out.Write(fUninfectedContacts);
+    }
+    void Read(CVCheckpointReader& in, CVDisease* disease) {
+      in.Read(fId);
+      int days[7];
+      in.Read(days);
+      fExposedOn   = days[0]; fInfectiousOn    = days[1]; fSymptomOnset = days[2]; fReportedOn = days[3];
+      fRecoveredOn = days[4]; fDayLastTestedOn = days[5]; fInfectedBy   = days[6];
+      bool flags[3];
+      in.Read(flags);
+      fHasSymptoms = flags[0]; fHasApp = flags[1]; fDoesReport = flags[2];
+      in.Read(fQuarantinedOn);
+      in.Read(fTracedOn);
+      //! (the days are those the person was made with)
+      in.ReadRuns(fInfectionStatus);
+      in.ReadRuns(fTracingStatus);
+      in.ReadRuns(fQuarantineStatus);
+      in.Read(fExposed);
+      in.Read(fDays);
+      in.Read(fUninfectedContacts);
+      if(fExposedOn > -1) fDisease = disease;
+    }
+
   protected:
     int        fId;      //! each person has a numeric ID
     CVDisease* fDisease; //! ... and might carry a disease
@@ -0,0 +1,131 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Wall clock time spent in the phases of a simulated day, and the amount of work done.
+ * Exactly one phase is running at a time; starting a phase stops the previous one.
+ * Also the memory use of the process, recorded once per run.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVPhaseTimer_H
+#define CVPhaseTimer_H
+
+//! c++
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+//! posix
+#include <unistd.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+//! phases of a day
+enum CVPhase {
+  P_Census,     ///< 0 - status of the people in rotation and removal of the recovered
+  P_Infection,  ///< 1 - drawing contacts and exposing victims
+  P_Reporting,  ///< 2 - reporting and testing
+  P_Tracing,    ///< 3 - tracing and quarantining contacts
+  P_Quarantine, ///< 4 - counting the population in quarantine
+  P_Output,     ///< 5 - R_t bookkeeping, tsv and root output of the day
+  Phase_COUNT   ///< Do not add anything after COUNT
+};
+
+//! countable work items
+enum CVWorkItem {
+  W_InfectionAttempts, ///< 0 - drawn victims
+  W_Traces,            ///< 1 - tried traces
+  W_Quarantines,       ///< 2 - quarantine orders
+  Work_COUNT           ///< Do not add anything after COUNT
+};
+
+static const char* const kCVPhaseNames[Phase_COUNT]   = { "Census", "Infection", "Reporting", "Tracing", "Quarantine", "Output" };
+static const char* const kCVWorkItemNames[Work_COUNT] = { "InfectionAttempts", "Traces", "Quarantines" };
+
+//! resident set size of the process [kB], now ..
+inline long CVResidentMemory() {
+  long pages = 0, residentPages = 0;
+  ifstream statm("/proc/self/statm");
+  statm >> pages >> residentPages;
+  return residentPages * (sysconf(_SC_PAGESIZE)/1024);
+}
+//! .. and the maximum so far
+inline long CVPeakResidentMemory() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+class CVPhaseTimer
+{
+  public:
+    typedef chrono::steady_clock Clock;
+
+    CVPhaseTimer() { Reset(); }
+
+    //! start a new run
+    void Reset() {
+      fill(fRunTime, fRunTime+Phase_COUNT, 0.);
+      fill(fRunCount,fRunCount+Work_COUNT, 0);
+      StartDay();
+    }
+    //! start a new day
+    void StartDay() {
+      fill(fDayTime, fDayTime+Phase_COUNT, 0.);
+      fill(fDayCount,fDayCount+Work_COUNT, 0);
+      fPhase = -1;
+    }
+    //! stop the running phase and add the day to the run
+    void EndDay() {
+      Stop();
+      for(int iphase = 0; iphase < Phase_COUNT; iphase++) fRunTime[iphase]  += fDayTime[iphase];
+      for(int iitem  = 0; iitem  < Work_COUNT;  iitem++ ) fRunCount[iitem]  += fDayCount[iitem];
+    }
+
+    void Start(CVPhase phase) {
+      Clock::time_point now = Clock::now();
+      if(fPhase > -1) fDayTime[fPhase] += chrono::duration<double,micro>(now - fStart).count();
+      fPhase = phase;
+      fStart = now;
+    }
+    void Stop() {
+      if(fPhase < 0) return;
+      fDayTime[fPhase] += chrono::duration<double,micro>(Clock::now() - fStart).count();
+      fPhase = -1;
+    }
+    void Count(CVWorkItem item, int n=1) { fDayCount[item] += n; }
+
+    //! getters, times in microseconds
+    double* GetDayTime(CVPhase phase)     { return &fDayTime[phase];  } //! for tree branches
+    int*    GetDayCount(CVWorkItem item)  { return &fDayCount[item];  } //! for tree branches
+    double  GetRunTime(CVPhase phase)     { return fRunTime[phase];   }
+    long    GetRunCount(CVWorkItem item)  { return fRunCount[item];   }
+
+  private:
+    int               fPhase;                 //! running phase, -1 if none
+    Clock::time_point fStart;                 //! when the running phase started
+    double            fDayTime[Phase_COUNT];  //! this day
+    int               fDayCount[Work_COUNT];
+    double            fRunTime[Phase_COUNT];  //! summed over the run
+    long              fRunCount[Work_COUNT];
+};
+
+#endif
@@ -53,6 +53,8 @@ DEALINGS IN THE SOFTWARE.
 #include <TPaveText.h>
 #include <TStopwatch.h>
 
+#include "CVGrowthRate.h"
+
 using namespace std;
 bool fDebug = 0; //! Enable or disable debug output
 bool fWriteTextfile = 0; //!Write results to a text file instead of to the default .root output file.
@@ -220,6 +222,7 @@ void postprocess(TFile *fin, int runner, string fname) {
   }
 	//! Loop on the PopulationLevelInformation tree to gather information on statistics in each 'box' of the disease.
 	TH1F *hNewlyInfected = new TH1F("hNewlyInfected","hNewlyInfected", 250,0,500);
+	CVGrowthRate growth; //! of the newly infected in the 6 weeks after interventions started
 	for (int ientry = 0; ientry < PopulationLevelInformation->GetEntries(); ientry++) {
 		PopulationLevelInformation->GetEntry(ientry);
 		//! The daily numbers are in the same tree for all simulations run. This splits them up so that we gather statistics for each run.
@@ -234,12 +237,13 @@ void postprocess(TFile *fin, int runner, string fname) {
 				hMaxTotalSick->Fill(float(maxtotalsick)/float(NPersons));
 				hSick1yr->Fill(float(sickByDay365)/float(NPersons));
 				hQuarantineSum->Fill(QuarantineManDays/float(NPersons)/365.);
-				//! Calculation of doublingTime currently disabled for speed reasons.
+				//! The TF1 fit in CalculateDoublingTime is too slow to run on every run, the closed form
+				//! least squares estimate of CVGrowthRate is used instead.
 				//doublingTime = CalculateDoublingTime(hNewlyInfected, fStartTestingOnDay, TMath::Min(fStartTestingOnDay+42, fLastDayWithPatients));
-				doublingTime = -9999.999				;
+				doublingTime = growth.GetDoublingTime();
 				if (fDebug) hNewlyInfected->DrawCopy();
 				if (fDebug) tt->SaveAs(Form("fit%d_%d.png",runner,filecounter));
-				hDoublingTime->Fill(doublingTime); 
+				if (doublingTime != CVGrowthRate::kNoEstimate) hDoublingTime->Fill(doublingTime);
 				hRe->Fill(avgRe/float(recounter));
 				hRePre->Fill(avgRePre/float(reprecounter));
 				if (fDebug) cout << "Re " << avgRePre/float(reprecounter) << ", " << avgRe/float(recounter) << endl;
@@ -247,7 +251,7 @@ void postprocess(TFile *fin, int runner, string fname) {
 			settings->GetEntry(filecounter);
 			maxdailysick = 0; maxq=0; maxtotalsick = 0; QuarantineManDays=0., doublingTime=0.0, avgRe =0.0, avgRePre = 0.0;
 			recounter=0; reprecounter=0;
-			hNewlyInfected->Reset(); LastNSusceptible=NPersons;			
+			hNewlyInfected->Reset(); growth.Reset(); LastNSusceptible=NPersons;			
 		}		
 	  if (fWriteTextfile) out << fDayForROOTTree << ", " << fNSusceptible<< ", " <<fNExposed<< ", " <<fNInfectious<< ", " <<fNRecovered<< ", " <<fNTraced<< ", " <<fNReported<< ", " <<feffectiveR<< ", " <<feffectiveRUncertainty<< ", " <<fNQuarantineToday << endl;		
 		maxtotalsick = NPersons-fNSusceptible;
@@ -263,6 +267,7 @@ void postprocess(TFile *fin, int runner, string fname) {
 		if (fDayForROOTTree > fStartTestingOnDay-calculateReFromInterventionStartToDay/2 && fDayForROOTTree < fStartTestingOnDay - 1 && feffectiveR > -1)  { avgRePre = avgRePre+feffectiveR; reprecounter++;}
 		if (fDayForROOTTree > fStartTestingOnDay && fDayForROOTTree < 365+fStartTestingOnDay) QuarantineManDays = QuarantineManDays + fNQuarantineToday;
 		hNewlyInfected->SetBinContent(hNewlyInfected->FindBin(fDayForROOTTree), LastNSusceptible - fNSusceptible ); // this will quietly ignore out-of-range bins
+		if (fDayForROOTTree >= fStartTestingOnDay && fDayForROOTTree <= fStartTestingOnDay+42) growth.AddDay(fDayForROOTTree, LastNSusceptible - fNSusceptible);
 		LastNSusceptible = fNSusceptible;
 		lastindex = fFileIndex;
 	}	
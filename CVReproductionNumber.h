@@ -0,0 +1,114 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Real-time reproduction number from the renewal equation: the new exposures I(t) of a day
+ * are expected to be R(t) times the infection pressure L(t) = sum_s w(s) I(t-s) of the
+ * exposures before, where w is the generation interval distribution, the days between the
+ * exposure of an infector and of its infectee (0 if the infectee infects on the day it was
+ * exposed). w is taken from the infections simulated so far. R(t) is the ratio of the sums
+ * of I and L over a sliding window of the last days, with a Poisson uncertainty. Unlike the
+ * effective R of the persons who recovered on a day, it does not lag by the infectious
+ * period. Each day costs O(window + longest interval).
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVReproductionNumber_H
+#define CVReproductionNumber_H
+
+//! c++
+#include <vector>
+#include <deque>
+#include <cmath>
+
+#include "CVCheckpoint.h"
+
+using namespace std;
+
+class CVRenewalEstimator
+{
+  public:
+    //! longest generation interval used [days]
+    static const int kMaxInterval = 40;
+
+    //! R(t) over the last .. days
+    CVRenewalEstimator(int window = 7) : fWindow(window) { Reset(); }
+
+    void Reset() {
+      fIntervals.assign(kMaxInterval+1,0);
+      fNIntervals = 0;
+      fIncidence.clear();
+      fWindowDays.clear();
+      fSumIncidence = fSumPressure = 0;
+    }
+    //! an infectee was exposed .. days after its infector
+    void AddGenerationInterval(int days) {
+      if(days >= 0 && days <= kMaxInterval) fIntervals[days]++;
+      fNIntervals++;
+    }
+    //! new exposures of the next day (days are added in order, starting with day 0)
+    void AddDay(int incidence) {
+      fIncidence.push_back(incidence);
+      double pressure = 0;
+      if(fNIntervals > 0) {
+        int today = fIncidence.size()-1;
+        for(int s = 0; s <= kMaxInterval && s <= today; s++)
+          if(fIntervals[s] > 0) pressure += fIntervals[s]*fIncidence[today-s];
+        pressure /= fNIntervals;
+      }
+      fWindowDays.push_back(make_pair(double(incidence),pressure));
+      fSumIncidence += incidence;
+      fSumPressure  += pressure;
+      if((int) fWindowDays.size() > fWindow) {
+        fSumIncidence -= fWindowDays.front().first;
+        fSumPressure  -= fWindowDays.front().second;
+        fWindowDays.pop_front();
+      }
+    }
+    //! -99 if there was no infection pressure in the window, as the effective R
+    float GetR() const { return HasPressure() ? fSumIncidence/fSumPressure : -99.; }
+    float GetRUncertainty() const { return HasPressure() ? sqrt(fSumIncidence)/fSumPressure : 0.; }
+
+    //! checkpoint of the intervals, the incidence and the window (see CVCheckpoint.h)
+    void Write(CVCheckpointWriter& out) const {
+      out.Write(fIntervals); out.Write(fNIntervals); out.Write(fIncidence);
+      out.Write(vector<pair<double,double> >(fWindowDays.begin(),fWindowDays.end()));
+      out.Write(fSumIncidence); out.Write(fSumPressure);
+    }
+    void Read(CVCheckpointReader& in) {
+      in.Read(fIntervals); in.Read(fNIntervals); in.Read(fIncidence);
+      vector<pair<double,double> > windowDays;
+      in.Read(windowDays);
+      fWindowDays.assign(windowDays.begin(),windowDays.end());
+      in.Read(fSumIncidence); in.Read(fSumPressure);
+    }
+
+  private:
+    bool HasPressure() const { return fSumPressure > 1e-9; }
+
+    int    fWindow;
+    vector<double> fIntervals;          //! infections by generation interval
+    double fNIntervals;
+    vector<int>    fIncidence;          //! new exposures by day
+    deque<pair<double,double> > fWindowDays; //! new exposures and infection pressure of the days in the window
+    double fSumIncidence, fSumPressure;
+};
+
+#endif
@@ -0,0 +1,152 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Outcome of a run, accumulated from the daily census while the simulation runs, with the
+ * definitions of CVPostProcess: peak load, total exposed, quarantine burden in the year after
+ * the intervention started, effective R before and after it, the doubling time of the new
+ * exposures after it, and whether there was an outbreak at all.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVRunSummary_H
+#define CVRunSummary_H
+
+//! c++
+#include <vector>
+#include <algorithm>
+
+#include "CVColumnFile.h" //! CVDayRecord
+#include "CVGrowthRate.h"
+
+using namespace std;
+
+//! one entry of the runSummary tree
+struct CVRunSummary {
+  int   fileIndex;
+  unsigned int randomSeed;
+  int   lastDayWithPatients;
+  int   startTestingOnDay;    //! 99999 if the intervention never started
+  int   maxDailySick;         //! most exposed and infectious on one day
+  int   maxQuarantine;        //! most in quarantine on one day
+  int   maxTotalSick;         //! exposed at some point
+  int   sickByDay365;         //! .. by one year after the intervention started
+  float quarantineManDays;    //! days spent in quarantine in that year
+  float averageRe;            //! effective R after the intervention started, -99 if no day qualified
+  int   nRe;                  //! days averaged
+  float averageRePre;         //! .. and before
+  int   nRePre;
+  float doublingTime;         //! of the daily new exposures after the intervention started [day], -99999 if too few
+  float doublingTimeUncertainty;
+  int   outbreak;             //! 1 if more were exposed than the intervention threshold, 0 if it fizzled
+};
+
+//! fills a CVRunSummary one day at a time
+class CVSummaryAccumulator
+{
+  public:
+    //! days used for the effective R after the intervention started
+    static const int kReWindow = 28;
+    //! days used for the doubling time after the intervention started
+    static const int kDoublingTimeWindow = 42;
+
+    //! an outbreak needs more exposed than it takes to start the intervention (at least 50 if
+    //! that is below 1e-4 of the population)
+    static int GetOutbreakThreshold(float startFraction, int nPersons) {
+      int threshold = int(startFraction*float(nPersons));
+      return startFraction < 0.0001 ? min(threshold,50) : threshold;
+    }
+    //! start a new run; an outbreak needs more than .. exposed
+    void Reset(int fileIndex, int nPersons, int outbreakThreshold) {
+      fSummary = CVRunSummary();
+      fSummary.fileIndex = fileIndex;
+      fSummary.startTestingOnDay = 99999;
+      fNPersons = nPersons;
+      fOutbreakThreshold = outbreakThreshold;
+      fRe.clear();
+      fReSum = fReSumPre = 0;
+      fLastNSusceptible = nPersons;
+      fGrowth.Reset();
+    }
+    //! the run the summary is written for, e.g. when it continues the days of another run
+    void SetFileIndex(int fileIndex) { fSummary.fileIndex = fileIndex; }
+    //! add the census of a day, with the intervention start as known on that day (while the
+    //! simulation runs) or already known before (reading a finished run)
+    void AddDay(const CVDayRecord& day, int startTestingOnDay) {
+      CVRunSummary& s = fSummary;
+      //! the intervention started today, the days before it are behind us
+      if(startTestingOnDay != s.startTestingOnDay) {
+        s.startTestingOnDay = startTestingOnDay;
+        for(int iday = max(0,startTestingOnDay-kReWindow/2+1); iday < min((int) fRe.size(),startTestingOnDay-1); iday++)
+          if(fRe[iday] > -1) { fReSumPre += fRe[iday]; s.nRePre++; }
+      }
+      int start = s.startTestingOnDay;
+      int totalSick = fNPersons - day.nSusceptible;
+      if(fRe.size() <= (size_t) day.day) fRe.resize(day.day+1, -99);
+      fRe[day.day] = day.effectiveR;
+
+      s.maxTotalSick  = max(s.maxTotalSick, totalSick);
+      s.maxDailySick  = max(s.maxDailySick, day.nExposed+day.nInfectious);
+      s.maxQuarantine = max(s.maxQuarantine, day.nQuarantineToday);
+      if(day.day <= 365+start) s.sickByDay365 = totalSick;
+      if(day.day > start && day.day < 365+start) s.quarantineManDays += day.nQuarantineToday;
+      if(day.day > start-kReWindow/2 && day.day < start-1 && day.effectiveR > -1)
+        { fReSumPre += day.effectiveR; s.nRePre++; }
+      //! skip the first 10 days, still dominated by exposures before the intervention, and stay
+      //! out of the non-linear regime
+      if(day.day > start+10 && day.day < start+kReWindow && day.effectiveR > -1 && totalSick < fNPersons/2.)
+        { fReSum += day.effectiveR; s.nRe++; }
+      if(day.day >= start && day.day <= start+kDoublingTimeWindow) fGrowth.AddDay(day.day, fLastNSusceptible-day.nSusceptible);
+      fLastNSusceptible = day.nSusceptible;
+    }
+    //! the summary of the run so far
+    CVRunSummary& GetSummary() {
+      fSummary.averageRe    = fSummary.nRe    ? fReSum/fSummary.nRe       : -99;
+      fSummary.averageRePre = fSummary.nRePre ? fReSumPre/fSummary.nRePre : -99;
+      fSummary.outbreak     = fSummary.maxTotalSick > fOutbreakThreshold;
+      fSummary.doublingTime = fGrowth.GetDoublingTime();
+      fSummary.doublingTimeUncertainty = fGrowth.GetDoublingTimeUncertainty();
+      return fSummary;
+    }
+
+    //! checkpoint of the summary so far (see CVCheckpoint.h)
+    void Write(CVCheckpointWriter& out) const {
+      out.Write(fSummary); out.Write(fNPersons); out.Write(fOutbreakThreshold); out.Write(fRe);
+      out.Write(fReSum); out.Write(fReSumPre); out.Write(fLastNSusceptible);
+      fGrowth.Write(out);
+    }
+    void Read(CVCheckpointReader& in) {
+      in.Read(fSummary); in.Read(fNPersons); in.Read(fOutbreakThreshold); in.Read(fRe);
+      in.Read(fReSum); in.Read(fReSumPre); in.Read(fLastNSusceptible);
+      fGrowth.Read(in);
+    }
+
+  private:
+    CVRunSummary  fSummary;
+    int           fNPersons;
+    int           fOutbreakThreshold;
+    vector<float> fRe;         //! effective R of the days so far, for the days before the intervention
+    double        fReSum;
+    double        fReSumPre;
+    int           fLastNSusceptible;
+    CVGrowthRate  fGrowth;     //! of the new exposures after the intervention started
+};
+
+#endif
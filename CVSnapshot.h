@@ -0,0 +1,199 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * The state of a run at the start of a day, from which other runs can continue. CVMC takes it
+ * on the day the interventions start, so that variants of the interventions share the days
+ * before them instead of simulating the same growth again: the persons that are not in their
+ * reset state, the people in rotation, the counters, the day records and summary so far, the
+ * diagnostic histograms and the random number generator. The events and state hashes of the
+ * days before are kept to be recorded again for every variant.
+ * Written to a file, the snapshot of any day is the checkpoint from which a stopped run
+ * continues (see CVCheckpoint.h); it then also holds the day the interventions started and
+ * the app users and reporters of the run.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVSnapshot_H
+#define CVSnapshot_H
+
+//! c++
+#include <vector>
+#include <string>
+#include <memory>
+#include <utility>
+
+//! root
+#include <TH1.h>
+#include <TH1F.h>
+#include <TDirectory.h>
+
+#include "CVPerson.h"
+#include "CVCommonRandom.h"
+#include "CVColumnFile.h"
+#include "CVRunSummary.h"
+#include "CVReproductionNumber.h"
+#include "CVEventLog.h"
+#include "CVBitColumn.h"
+#include "CVCheckpoint.h"
+
+using namespace std;
+
+struct CVSnapshot {
+  int day = -1;                 //! the day the variants start with, -1 until taken
+  CVCommonRandom seeded;        //! the generator as seeded, for the draws of the reset
+  CVCommonRandom random;        //! .. and at the start of the day
+  vector<CVPerson> persons;     //! copies of the persons that are not in their reset state
+  vector<int> inRotation;       //! IDs of the people who are exposed and not yet recovered
+  vector<int> toErase;          //! .. who recovered and are removed at the start of the day
+  vector<int> timeOrderedListOfInfectedIDs;
+  int totalReported;
+  int totalSick;
+  vector<int> nQuarantine;
+  vector<int> numberRecoveredByDay;
+  vector<int> numberInfectiousByDay;
+  vector<int> numberNewlyInfectedByDay;
+  vector<CVDayRecord> days;     //! census of the days before
+  CVSummaryAccumulator summary;
+  CVGrowthRate dailyGrowthRate;
+  CVRenewalEstimator renewal;
+  vector<unique_ptr<TH1> > histograms; //! copies of the diagnostic histograms
+  int lastDayWithPatients;
+  int nSusceptible;             //! of the day before, for the new exposures of the day
+  int nRecovered;               //! .. and all who recovered so far
+  int dayForROOTTree;
+  float effectiveR;
+  float effectiveRUncertainty;
+  int nQuarantineToday;
+  //! dot output of the debug mode
+  int peopleInDotFile;
+  int lastDayForDot;
+  int lastDayForDotSimple;
+  string dotStringPeople;
+  string dotStringPeopleSimple;
+  //! events and state hashes of the days before, collected while they are simulated
+  vector<CVEvent> events;
+  vector<pair<int,ULong64_t> > hashes; //! day and rolling hash
+  vector<ULong64_t> blockHashes;       //! .. and the hashes of the blocks of these days
+  //! only in checkpoints, which are taken on any day
+  int startTracingOnDay = 99999; //! the day the interventions started
+  CVBitColumn hasApp;            //! .. and the attributes of the persons, empty to keep those drawn
+  CVBitColumn doesReport;
+
+  //! write to a checkpoint, without the events, which are in the event file already, and the
+  //! dot output of the debug mode
+  void Write(CVCheckpointWriter& out) {
+    random.Write(out);
+    hasApp.Write(out);
+    doesReport.Write(out);
+    out.Write(uint64_t(persons.size()));
+    for (auto& person : persons) person.Write(out);
+    out.Write(inRotation);
+    out.Write(toErase);
+    out.Write(timeOrderedListOfInfectedIDs);
+    int counters[] = { totalReported, totalSick, startTracingOnDay, lastDayWithPatients, nSusceptible, nRecovered, 
+                       dayForROOTTree, nQuarantineToday };
+    out.Write(counters);
+    out.Write(effectiveR);
+    out.Write(effectiveRUncertainty);
+    out.Write(nQuarantine);
+    out.Write(numberRecoveredByDay);
+    out.Write(numberInfectiousByDay);
+    out.Write(numberNewlyInfectedByDay);
+    out.Write(days);
+    summary.Write(out);
+    dailyGrowthRate.Write(out);
+    renewal.Write(out);
+    out.Write(uint64_t(histograms.size()));
+    for (auto& hist : histograms) {
+      vector<double> contents(hist->GetNbinsX()+2);
+      for (size_t ibin = 0; ibin < contents.size(); ibin++) contents[ibin] = hist->GetBinContent(ibin);
+      double stats[13] = {}; //! TH1::kNstat, of which one dimension uses 4
+      hist->GetStats(stats);
+      out.Write(contents);
+      out.Write(stats);
+      out.Write(hist->GetEntries());
+    }
+    out.Write(hashes);
+    out.Write(blockHashes);
+  }
+  //! read a checkpoint, with the persons of a population of .. days, its generator and disease,
+  //! and the histograms as copies of ..; false if it is incomplete or does not fit
+  bool Read(CVCheckpointReader& in, int nDays, TRandom3* random, CVDisease* disease, const vector<TH1F*>& templates) {
+    day = in.GetHeader().day;
+    this->random.Read(in);
+    hasApp.Read(in);
+    doesReport.Read(in);
+    uint64_t npersons = 0;
+    in.Read(npersons);
+    if (!in.IsGood() || npersons > uint64_t(hasApp.GetSize())) return false;
+    persons.clear();
+    persons.reserve(npersons);
+    for (uint64_t iperson = 0; iperson < npersons && in.IsGood(); iperson++) {
+      persons.emplace_back(0,nDays,random);
+      persons.back().Read(in,disease);
+    }
+    in.Read(inRotation);
+    in.Read(toErase);
+    in.Read(timeOrderedListOfInfectedIDs);
+    int counters[8];
+    in.Read(counters);
+    totalReported       = counters[0]; totalSick    = counters[1]; startTracingOnDay = counters[2]; 
+    lastDayWithPatients = counters[3]; nSusceptible = counters[4]; nRecovered        = counters[5]; 
+    dayForROOTTree      = counters[6]; nQuarantineToday = counters[7];
+    in.Read(effectiveR);
+    in.Read(effectiveRUncertainty);
+    in.Read(nQuarantine);
+    in.Read(numberRecoveredByDay);
+    in.Read(numberInfectiousByDay);
+    in.Read(numberNewlyInfectedByDay);
+    in.Read(days);
+    summary.Read(in);
+    dailyGrowthRate.Read(in);
+    renewal.Read(in);
+    uint64_t nhistograms = 0;
+    in.Read(nhistograms);
+    if (!in.IsGood() || nhistograms != templates.size()) return false;
+    TDirectory::TContext context(0); //! the copies belong to no directory
+    histograms.clear();
+    for (auto temp : templates) {
+      vector<double> contents;
+      double stats[13];
+      double entries;
+      in.Read(contents);
+      in.Read(stats);
+      in.Read(entries);
+      if (!in.IsGood() || contents.size() != size_t(temp->GetNbinsX()+2)) return false;
+      TH1* hist = (TH1*) temp->Clone();
+      hist->Reset();
+      for (size_t ibin = 0; ibin < contents.size(); ibin++) hist->SetBinContent(ibin,contents[ibin]);
+      hist->PutStats(stats);
+      hist->SetEntries(entries);
+      histograms.emplace_back(hist);
+    }
+    in.Read(hashes);
+    in.Read(blockHashes);
+    peopleInDotFile = lastDayForDot = lastDayForDotSimple = 0;
+    dotStringPeople = dotStringPeopleSimple = "";
+    return in.IsGood();
+  }
+};
+
+#endif
@@ -0,0 +1,62 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Hashes of the simulation state, used to find the first day on which two builds or
+ * two versions of the day loop diverge.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVStateHash_H
+#define CVStateHash_H
+
+//! c++
+#include <cstdint>
+
+#include "CVPerson.h"
+
+using namespace std;
+
+//! finalizer of splitmix64: a bijection of 64 bit words in which every input bit affects every output bit
+inline uint64_t CVHashMix(uint64_t x) {
+  x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+//! fold value into hash, the result depends on the order of the values
+inline uint64_t CVHashCombine(uint64_t hash, uint64_t value) {
+  return CVHashMix(hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6)));
+}
+//! state of a person on day .., packed into three words to keep the hashing cheap
+inline uint64_t CVHashPerson(int index, CVPerson* person, int day, bool hasApp) {
+  uint64_t events  = uint32_t(person->GetExposedOn())       | uint64_t(uint32_t(person->GetReportedOn())) << 32;
+  uint64_t history = uint32_t(person->GetDayLastTestedOn()) | uint64_t(uint32_t(person->GetInfectedBy())) << 32;
+  uint64_t status  = uint64_t(person->GetInfectionStatus(day))
+                   | uint64_t(person->GetTracingStatus(day))        <<  8
+                   | uint64_t(person->GetQuarantineStatus(day))     << 16
+                   | uint64_t(hasApp)                               << 17
+                   | uint64_t(person->GetNTracedOn()      & 0xfff)  << 24
+                   | uint64_t(person->GetNQuarantinedOn() & 0xfff)  << 36
+                   | uint64_t(person->GetNExposed()       & 0xffff) << 48;
+  return CVHashCombine(CVHashCombine(CVHashCombine(index, events), history), status);
+}
+
+#endif
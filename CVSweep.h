@@ -0,0 +1,222 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Parameter sweeps in the json input. Any parameter can be given as
+ *   a list of values:                  "AppProbability": [0.2, 0.4, 0.6]
+ *   a range:                           "TracingDelay": {"from": 0, "to": 4, "step": 1}
+ *                                      (or "n": number of equidistant values instead of "step")
+ *   an interval to sample:             "TransmissionProbability": {"min": 0.05, "max": 0.1}
+ * Lists and ranges span a grid; the intervals are sampled with the design in
+ *   "Sweep": {"design": "lhs" or "sobol", "points": 64, "seed": 1}
+ * (Latin hypercube, or the Sobol sequence with the direction numbers of Joe and Kuo). Every
+ * grid point is combined with every sampled point. Intervals with integer bounds give integers.
+ * The points are numbered with the last grid parameter fastest, then the sampled points.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+#ifndef CVSweep_H
+#define CVSweep_H
+
+//! c++
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+
+//! root
+#include <TRandom3.h>
+
+//! external (included in project)
+#include "json.hpp"
+
+using namespace std;
+
+class CVSweep
+{
+  public:
+    using json = nlohmann::json;
+
+    //! the sweep specified in input; an input without sweep specifications is its only point
+    CVSweep(const json& input) : fInput(input) {
+      fInput.erase("Sweep");
+      Collect(fInput, json::json_pointer());
+      if(!fError.empty()) return;
+      const json sweep = input.count("Sweep") ? input["Sweep"] : json::object();
+      fNSampled = fSampled.empty() ? 1 : sweep.value("points", 0);
+      if(fSampled.empty()) return;
+      if(fNSampled < 1) { fError = "Sweep needs \"points\" to sample the intervals"; return; }
+      const string design = sweep.value("design", string("lhs"));
+      if(design == "lhs") DrawLatinHypercube(sweep.value("seed", 1));
+      else if(design == "sobol") DrawSobol();
+      else fError = "unknown Sweep design " + design + " (lhs or sobol)";
+    }
+
+    bool   IsValid()  const { return fError.empty(); }
+    string GetError() const { return fError; }
+    int    GetNPoints() const {
+      int n = fNSampled;
+      for(auto& axis : fGrid) n *= axis.values.size();
+      return n;
+    }
+    //! the input with the values of point .. (0 .. GetNPoints()-1)
+    json GetPoint(int ipoint) const {
+      json point = fInput;
+      for(auto& parameter : GetValues(ipoint)) point[parameter.first] = parameter.second;
+      return point;
+    }
+    //! the swept parameters and their values at point .., e.g. "AppProbability=0.4 TracingDelay=2"
+    string Describe(int ipoint) const {
+      ostringstream description;
+      for(auto& parameter : GetValues(ipoint))
+        description << (description.tellp() > 0 ? " " : "") << parameter.first.to_string().substr(1) << "=" << parameter.second;
+      return description.str();
+    }
+
+  private:
+    //! a parameter with a list of values, on the grid
+    struct Axis {
+      json::json_pointer pointer;
+      vector<json> values;
+    };
+    //! a parameter sampled from an interval
+    struct Dimension {
+      json::json_pointer pointer;
+      double min, max;
+      bool   integer;
+    };
+
+    //! find the sweep specifications in the input (they are replaced by the values of each point)
+    void Collect(const json& node, const json::json_pointer& pointer) {
+      if(node.is_array()) {
+        if(node.empty()) { fError = pointer.to_string() + " has no values"; return; }
+        fGrid.push_back({pointer, vector<json>(node.begin(), node.end())});
+      }
+      else if(node.is_object() && node.count("from")) {
+        if(!node.count("to") || (!node.count("step") && !node.count("n"))) { fError = pointer.to_string() + " needs \"to\" and \"step\" or \"n\""; return; }
+        const double from = node["from"], to = node["to"];
+        const bool integer = node["from"].is_number_integer() && node.value("step", json(1)).is_number_integer();
+        const int n = node.count("n") ? int(node["n"]) : int(floor((to-from)/double(node["step"]) + 1e-9)) + 1;
+        if(n < 1) { fError = pointer.to_string() + " has no values"; return; }
+        Axis axis = {pointer, {}};
+        for(int ivalue = 0; ivalue < n; ivalue++) {
+          const double value = n > 1 && node.count("n") ? from + (to-from)*ivalue/(n-1) : from + ivalue*double(node.value("step", 0.));
+          axis.values.push_back(integer && !node.count("n") ? json(llround(value)) : json(value));
+        }
+        fGrid.push_back(axis);
+      }
+      else if(node.is_object() && node.count("min")) {
+        if(!node.count("max")) { fError = pointer.to_string() + " needs \"max\""; return; }
+        fSampled.push_back({pointer, node["min"], node["max"], node["min"].is_number_integer() && node["max"].is_number_integer()});
+      }
+      else if(node.is_object()) {
+        for(auto it = node.begin(); it != node.end(); ++it) Collect(it.value(), pointer / it.key());
+        return;
+      }
+      else return;
+    }
+
+    //! the values of the swept parameters at point ..
+    vector<pair<json::json_pointer,json> > GetValues(int ipoint) const {
+      vector<pair<json::json_pointer,json> > values;
+      const int isample = ipoint % fNSampled;
+      int igrid = ipoint / fNSampled;
+      for(int iaxis = fGrid.size()-1; iaxis >= 0; iaxis--) {
+        values.push_back({fGrid[iaxis].pointer, fGrid[iaxis].values[igrid % fGrid[iaxis].values.size()]});
+        igrid /= fGrid[iaxis].values.size();
+      }
+      reverse(values.begin(), values.end());
+      for(size_t idim = 0; idim < fSampled.size(); idim++) {
+        const Dimension& d = fSampled[idim];
+        const double u = fUnit[isample][idim];
+        if(d.integer) values.push_back({d.pointer, json(min<long long>(llround(d.max), llround(d.min) + (long long)(u*(d.max-d.min+1))))});
+        else          values.push_back({d.pointer, json(d.min + u*(d.max-d.min))});
+      }
+      return values;
+    }
+
+    //! one point in each of fNSampled equal strata of every dimension, the strata paired at random
+    void DrawLatinHypercube(int seed) {
+      TRandom3 random(seed);
+      fUnit.assign(fNSampled, vector<double>(fSampled.size()));
+      vector<int> strata(fNSampled);
+      for(size_t idim = 0; idim < fSampled.size(); idim++) {
+        iota(strata.begin(), strata.end(), 0);
+        for(int i = fNSampled-1; i > 0; i--) swap(strata[i], strata[random.Integer(i+1)]);
+        for(int isample = 0; isample < fNSampled; isample++) fUnit[isample][idim] = (strata[isample] + random.Uniform())/fNSampled;
+      }
+    }
+
+    //! the first fNSampled points of the Sobol sequence, in gray code order
+    void DrawSobol() {
+      //! degree, coefficients and initial direction numbers of dimensions 2 .. 21 (Joe and Kuo, new-joe-kuo-6.21201)
+      static const int kNTable = 20;
+      static const int degree[kNTable] = { 1, 2, 3, 3, 4, 4, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 7, 7 };
+      static const int coefficients[kNTable] = { 0, 1, 1, 2, 1, 4, 2, 4, 7, 11, 13, 14, 1, 13, 16, 19, 22, 25, 1, 4 };
+      static const int initial[kNTable][7] = {
+        {1}, {1,3}, {1,3,1}, {1,1,1}, {1,1,3,3}, {1,3,5,13}, {1,1,5,5,17}, {1,1,5,5,5}, {1,1,7,11,19}, {1,1,5,1,1},
+        {1,1,1,3,11}, {1,3,5,5,31}, {1,3,3,9,7,49}, {1,1,1,15,21,21}, {1,3,1,13,27,49}, {1,1,1,15,7,5}, {1,3,1,15,13,25},
+        {1,1,5,5,19,61}, {1,3,7,11,23,15,103}, {1,3,7,13,13,15,69}
+      };
+      if((int) fSampled.size() > kNTable+1) {
+        fError = "the Sobol design has at most " + to_string(kNTable+1) + " parameters";
+        return;
+      }
+      const int kBits = 32;
+      fUnit.assign(fNSampled, vector<double>(fSampled.size()));
+      for(size_t idim = 0; idim < fSampled.size(); idim++) {
+        //! direction numbers v[k] = m[k]/2^(k+1), as fractions of 2^32
+        vector<uint32_t> v(kBits);
+        if(idim == 0) for(int k = 0; k < kBits; k++) v[k] = 1u << (kBits-1-k);
+        else {
+          const int s = degree[idim-1], a = coefficients[idim-1];
+          vector<uint32_t> m(kBits);
+          for(int k = 0; k < kBits; k++) {
+            if(k < s) m[k] = initial[idim-1][k];
+            else {
+              m[k] = m[k-s] ^ (m[k-s] << s);
+              for(int j = 1; j < s; j++) if((a >> (s-1-j)) & 1) m[k] ^= m[k-j] << j;
+            }
+            v[k] = m[k] << (kBits-1-k);
+          }
+        }
+        uint32_t x = 0;
+        for(int isample = 0; isample < fNSampled; isample++) {
+          fUnit[isample][idim] = x/4294967296.;
+          //! the next point differs in the direction of the lowest zero bit of the index
+          int bit = 0;
+          while((isample >> bit) & 1) bit++;
+          x ^= v[min(bit, kBits-1)];
+        }
+      }
+    }
+
+    json   fInput;                  //! without the Sweep settings
+    string fError;
+    vector<Axis>      fGrid;
+    vector<Dimension> fSampled;
+    int    fNSampled = 1;           //! points sampled from the intervals
+    vector<vector<double> > fUnit;  //! the sampled points in the unit cube
+};
+
+#endif
@@ -0,0 +1,843 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compiled version of CVPostProcess: the summary outcomes of all runs in output files of
+ * runCVMC, written to a MCSummary tree as by postprocess(). The daily tree is read once, in
+ * order; the runs are located by their offsets in it while reading, and the outcomes and the
+ * curves of every run for the overview canvas are collected in the same pass. Files with a
+ * runSummary tree (one row per run) are summarized from it without reading the daily tree.
+ * Directories are expanded to the root files in them, and the files are summarized by several
+ * threads. A cache of the outcomes of every file, keyed by its size, modification time and
+ * content hash and the resamples and level of the intervals, skips the files that were
+ * summarized before and did not change. Optionally,
+ * the bands of the daily census over the runs of all files are merged into one tree. Every
+ * outcome comes with a bootstrap confidence interval and a jackknife error over the runs.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+
+//c++
+#include <vector>
+#include <map>
+#include <set>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "getopt.h"
+#include "json.hpp"
+
+//root
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1F.h>
+#include <TGraph.h>
+#include <TPaveText.h>
+#include <TText.h>
+
+#include "CVDiagnostics.h" //! makeLegend
+#include "CVRunSummary.h"  //! also CVGrowthRate
+#include "CVStateHash.h"  //! CVHashCombine
+#include "CVEnsembleBands.h"
+#include "CVBootstrap.h"
+
+using namespace std;
+
+//! accessible via optarg
+string gOutputDir = "."; //! Summary_<file> is written here
+bool   gOverview  = 0;   //! draw the daily curves of all runs and the outcomes to overview_<file>.png
+bool   gDaily     = 0;   //! recompute the outcomes from the daily tree even if there is a runSummary tree
+bool   gVerbose   = 0;   //! print the outcome of every run
+int    gThreads   = 1;   //! files summarized at the same time
+string gCache     = "";  //! cache of the outcomes of every file (default: <output directory>/analyzeCVMC_cache.json, "none" for no cache)
+bool   gForce     = 0;   //! summarize all files, also those in the cache
+string gBands     = "";  //! bands of the daily census over the runs of all files are written here (empty=off)
+int    gResamples = 1000;//! bootstrap resamples of the runs for the confidence intervals (0=none)
+double gConfidence = 0.95; //! of the intervals
+int    gBootstrapThreads = 1; //! threads resampling the runs of a file, those not needed for files
+
+//! outcomes of all runs in a file, the MCSummary entries that do not come from the settings
+struct CVOutcomes {
+  float nRuns;
+  float fractionNoOutbreak, fractionNoOutbreak50;
+  float averagemaxdailysick, averagemaxdailysickWidth, averagemaxq, averagemaxqWidth, averagemaxtotalsick;
+  float averagesickByDay365, averagesickByDay365Width, averageQuarantineManDays, averageQuarantineManDaysWidth;
+  float averageDoublingTime, averageReAfterIntervention, averageReAfterInterventionWidth, averageReBeforeIntervention;
+  vector<CVBootstrap::Interval> intervals; //! of the fields, in their order (not cached)
+
+  //! name and value of the MCSummary branches
+  vector<pair<const char*,float*> > Fields() {
+    return {
+      {"fractionNoOutbreak",   &fractionNoOutbreak},
+      {"fractionNoOutbreak50", &fractionNoOutbreak50},
+      {"averagemaxdailysick",      &averagemaxdailysick},
+      {"averagemaxdailysickWidth", &averagemaxdailysickWidth},
+      {"averagemaxq",      &averagemaxq},
+      {"averagemaxqWidth", &averagemaxqWidth},
+      {"averagemaxtotalsick",      &averagemaxtotalsick},
+      {"averagesickByDay365",      &averagesickByDay365},
+      {"averagesickByDay365Width", &averagesickByDay365Width},
+      {"averageQuarantineManDays",      &averageQuarantineManDays},
+      {"averageQuarantineManDaysWidth", &averageQuarantineManDaysWidth},
+      {"averageDoublingTime", &averageDoublingTime},
+      {"averageReAfterIntervention",      &averageReAfterIntervention},
+      {"averageReAfterInterventionWidth", &averageReAfterInterventionWidth},
+      {"averageReBeforeIntervention",     &averageReBeforeIntervention}
+    };
+  }
+};
+
+//! an input file and what the cache knows about it
+struct CVInputFile {
+  string    name;
+  string    output;            //! its Summary_ file
+  long long size, mtime;       //! [bytes], [ns]
+  string    hash;              //! of the content, hex, empty until computed
+  bool      cached = false;    //! outcomes taken from the cache
+  bool      done   = false;    //! summarized or taken from the cache
+  CVOutcomes outcomes;
+};
+
+//! where the days of a run are in PopulationLevelInformation
+struct CVRunIndex {
+  int      fileIndex;
+  Long64_t firstEntry;
+  Long64_t nEntries;
+};
+
+//! daily curves of a run as fractions of the population, for the overview canvas
+struct CVRunCurves {
+  vector<double> day, susceptible, sick, reported, quarantined, quarantinedNotSick;
+};
+
+//! connect a branch for reading or writing
+template<class T> void Connect(TTree* tree, const char* name, T* address, bool output)
+{
+  if(output) tree->Branch(name,address);
+  else       tree->SetBranchAddress(name,address);
+}
+
+//! the settings of a run, as written by CVMC::WriteROOTFile, and copied to MCSummary
+struct CVRunSettings {
+  int   nPersons, nDays, lastDayWithPatients, daysInQuarantine, tracingOrder, startTracingOnDay;
+  int   daysBackwardTrace, dTTest, daysToTestResult, tracingDelay, socialDistancingFrom, socialDistancingTo;
+  float peopleMetPerDay, startTracingTestingInfectedFraction, testThreshold, appProbability, tracingEfficiency;
+  float randomTestingRate, symptomProbability, reportingProbability, testPositiveProbability, falsePositiveRate;
+  float transmissionProbability, R00, R0e, asymptomaticTransmissionScaling;
+  float incubationGamma, incubationMu, incubationBeta, infectionGamma, infectionMu, infectionBeta;
+  float socialDistancingMaxPeople, socialDistancingFactor;
+  bool  backwardTracing, traceUninfected, randomTesting;
+
+  //! the branches common to settings and MCSummary
+  void Connect(TTree* tree, bool output) {
+    ::Connect(tree, "nPersons", &nPersons, output);
+    ::Connect(tree, "nDays",    &nDays,    output);
+    ::Connect(tree, "peopleMetPerDay",  &peopleMetPerDay,  output);
+    ::Connect(tree, "daysInQuarantine", &daysInQuarantine, output);
+    ::Connect(tree, "tracingOrder",     &tracingOrder,     output);
+    ::Connect(tree, "startTracingTestingInfectedFraction", &startTracingTestingInfectedFraction, output);
+    ::Connect(tree, "startTracingOnDay", &startTracingOnDay, output);
+    ::Connect(tree, "daysBackwardTrace", &daysBackwardTrace, output);
+    ::Connect(tree, "backwardTracing",   &backwardTracing,   output);
+    ::Connect(tree, "traceUninfected",   &traceUninfected,   output);
+    ::Connect(tree, "dTTest",            &dTTest,            output);
+    ::Connect(tree, "testThreshold",     &testThreshold,     output);
+    ::Connect(tree, "AppProbability",    &appProbability,    output);
+    ::Connect(tree, "tracingEfficiency", &tracingEfficiency, output);
+    ::Connect(tree, "daysToTestResult",  &daysToTestResult,  output);
+    ::Connect(tree, "randomTestingRate", &randomTestingRate, output);
+    ::Connect(tree, "randomTesting",     &randomTesting,     output);
+    ::Connect(tree, "symptomProbability",      &symptomProbability,      output);
+    ::Connect(tree, "ReportingProbability",    &reportingProbability,    output);
+    ::Connect(tree, "testPositiveProbability", &testPositiveProbability, output);
+    ::Connect(tree, "falsePositiveRate",       &falsePositiveRate,       output);
+    ::Connect(tree, "transmissionProbability", &transmissionProbability, output);
+    ::Connect(tree, "R00", &R00, output);
+    ::Connect(tree, "R0e", &R0e, output);
+    ::Connect(tree, "TracingDelay", &tracingDelay, output);
+    ::Connect(tree, "AsymptomaticTransmissionScaling", &asymptomaticTransmissionScaling, output);
+    ::Connect(tree, "incubationGamma", &incubationGamma, output);
+    ::Connect(tree, "incubationMu",    &incubationMu,    output);
+    ::Connect(tree, "incubationBeta",  &incubationBeta,  output);
+    ::Connect(tree, "infectionGamma",  &infectionGamma,  output);
+    ::Connect(tree, "infectionMu",     &infectionMu,     output);
+    ::Connect(tree, "infectionBeta",   &infectionBeta,   output);
+    ::Connect(tree, "SocialDistancingMaxPeople", &socialDistancingMaxPeople, output);
+    ::Connect(tree, "SocialDistancingFrom",      &socialDistancingFrom,      output);
+    ::Connect(tree, "SocialDistancingTo ",       &socialDistancingTo,        output);
+    ::Connect(tree, "SocialDistancingFactor",    &socialDistancingFactor,    output);
+  }
+};
+
+bool Analyze(const string& filename, const string& output, CVOutcomes& outcomes, ostream& log, CVEnsembleBands* bands);
+string HashFile(const string& filename);
+bool AddInput(const string& path, vector<CVInputFile>& inputs);
+void DrawOverview(const string& name, TFile* file, const CVRunSettings& settings,
+                  const vector<CVRunCurves>& curves, const vector<TH1F*>& outcomes);
+void Usage(const char* const exe);
+int  GetOptions(int argc, char** argv);
+
+int main(int argc, char** argv)
+{
+  //! get option input
+  const int nOptions = GetOptions(argc, argv);
+  if(nOptions < 0 || argc - nOptions < 1 || gThreads < 1) {
+    Usage(argv[0]);
+    return 1;
+  };
+  gROOT->SetBatch();
+  ROOT::EnableThreadSafety();
+  TH1::AddDirectory(false);
+
+  //! the root files, also those in directories
+  vector<CVInputFile> inputs;
+  int nFailed = 0;
+  for(int iarg = nOptions; iarg < argc; iarg++)
+    if(!AddInput(argv[iarg], inputs)) nFailed++;
+
+  //! take the files that did not change from the cache; the content is only hashed if the size
+  //! is the same but the modification time is not, e.g. after copying
+  using json = nlohmann::json;
+  if(gCache == "") gCache = gOutputDir + "/analyzeCVMC_cache.json";
+  json cache = json::object();
+  if(gCache != "none") {
+    ifstream cacheFile(gCache);
+    if(cacheFile.good()) {
+      try { cacheFile >> cache; }
+      catch(json::exception& e) { cout << "Warning, ignoring unreadable cache " << gCache << ": " << e.what() << endl; cache = json::object(); }
+    }
+  }
+  for(auto& input : inputs) {
+    struct stat summaryStat;
+    //! (the bands and the overview need the daily tree of every file)
+    if(gForce || gBands != "" || gOverview || !cache.count(input.name) || stat(input.output.c_str(), &summaryStat) != 0) continue;
+    json& entry = cache[input.name];
+    //! .. and the intervals in the Summary_ file must be those asked for
+    try {
+      if(!entry.is_object() || !entry["summary"].is_object()) continue;
+      if(entry.value("size", -1LL) != input.size) continue;
+      if(entry.value("resamples", -1) != gResamples || entry.value("confidence", -1.) != gConfidence) continue;
+      if(entry.value("mtime", -1LL) != input.mtime) {
+        input.hash = HashFile(input.name);
+        if(input.hash != entry.value("hash", string())) continue;
+      }
+      input.hash = entry.value("hash", string());
+      for(auto& field : input.outcomes.Fields()) *field.second = entry["summary"].value(field.first, 0.f);
+      input.outcomes.nRuns = entry["summary"].value("nRuns", 0.f);
+    }
+    catch(json::exception& e) { 
+      cout << "Warning, ignoring the unreadable cache entry of " << input.name << ": " << e.what() << endl; 
+      continue; 
+    }
+    input.cached = input.done = true;
+    cout << input.name << ": unchanged, " << input.outcomes.nRuns << " runs, " << input.outcomes.fractionNoOutbreak
+         << " without outbreak, Re " << input.outcomes.averageReBeforeIntervention << " -> "
+         << input.outcomes.averageReAfterIntervention << endl;
+  }
+
+  //! summarize the others, each thread takes the next file when it is done; the threads that
+  //! get no file resample the runs
+  const int nToDo = count_if(inputs.begin(), inputs.end(), [](const CVInputFile& input) { return !input.done; });
+  gBootstrapThreads = max(1, gThreads/max(1, min(gThreads, nToDo)));
+  //! and merges its bands into those of all files at the end
+  atomic<size_t> next(0);
+  atomic<int>    failed(0);
+  mutex printing;
+  CVEnsembleBands bands;
+  auto Work = [&]() {
+    CVEnsembleBands threadBands;
+    for(size_t ifile = next++; ifile < inputs.size(); ifile = next++) {
+      CVInputFile& input = inputs[ifile];
+      if(input.done) continue;
+      ostringstream log;
+      input.done = Analyze(input.name, input.output, input.outcomes, log, gBands != "" ? &threadBands : 0);
+      if(!input.done) failed++;
+      else if(gCache != "none" && input.hash == "") input.hash = HashFile(input.name);
+      lock_guard<mutex> lock(printing);
+      cout << log.str() << flush;
+    }
+    lock_guard<mutex> lock(printing);
+    bands.Merge(threadBands);
+  };
+  vector<thread> workers;
+  for(int ithread = 1; ithread < gThreads; ithread++) workers.push_back(thread(Work));
+  Work();
+  for(auto& worker : workers) worker.join();
+  nFailed += failed;
+  if(gBands != "") {
+    TFile bandsFile(gBands.c_str(),"RECREATE");
+    if(bandsFile.IsZombie()) {
+      cout << "Error, could not write " << gBands << endl;
+      nFailed++;
+    }
+    else {
+      bands.MakeTree()->Write();
+      bandsFile.Close();
+      cout << "Bands of " << bands.GetNRuns() << " runs written to " << gBands << endl;
+    }
+  }
+
+  if(gCache != "none") {
+    for(auto& input : inputs) {
+      if(!input.done) continue;
+      json summary = { {"nRuns", input.outcomes.nRuns} };
+      for(auto& field : input.outcomes.Fields()) summary[field.first] = *field.second;
+      cache[input.name] = { {"size", input.size}, {"mtime", input.mtime}, {"hash", input.hash}, 
+                            {"resamples", gResamples}, {"confidence", gConfidence}, {"summary", summary} };
+    }
+    ofstream cacheFile(gCache);
+    cacheFile << cache.dump(1) << endl;
+    if(!cacheFile.good()) cout << "Warning, could not write the cache " << gCache << endl;
+  }
+  int nCached = count_if(inputs.begin(), inputs.end(), [](const CVInputFile& input) { return input.cached; });
+  cout << "Processed " << inputs.size() - failed << " files (" << nCached << " unchanged)" << endl;
+  return nFailed ? 1 : 0;
+}
+
+//! a root file, or the root files in a directory (not the Summary_ files written here)
+bool AddInput(const string& path, vector<CVInputFile>& inputs)
+{
+  struct stat st;
+  if(stat(path.c_str(), &st) != 0) {
+    cout << "Error, could not access " << path << endl;
+    return false;
+  }
+  if(S_ISDIR(st.st_mode)) {
+    DIR* dir = opendir(path.c_str());
+    if(!dir) {
+      cout << "Error, could not read directory " << path << endl;
+      return false;
+    }
+    vector<string> names;
+    for(dirent* entry = readdir(dir); entry; entry = readdir(dir)) {
+      string name = entry->d_name;
+      if(name.size() > 5 && name.substr(name.size()-5) == ".root" && name.find("Summary_") != 0) names.push_back(name);
+    }
+    closedir(dir);
+    sort(names.begin(), names.end());
+    bool ok = true;
+    for(auto& name : names) ok &= AddInput(path + "/" + name, inputs);
+    return ok;
+  }
+  //! the cache is keyed by the absolute path
+  char absolute[PATH_MAX];
+  CVInputFile input;
+  input.name   = realpath(path.c_str(), absolute) ? absolute : path;
+  input.output = gOutputDir + "/Summary_" + input.name.substr(input.name.rfind('/')+1);
+  input.size   = st.st_size;
+  input.mtime  = st.st_mtim.tv_sec*1000000000LL + st.st_mtim.tv_nsec;
+  inputs.push_back(input);
+  return true;
+}
+
+//! 64 bit hash of the content of a file, in hex
+string HashFile(const string& filename)
+{
+  ifstream file(filename, ios::binary);
+  vector<uint64_t> buffer(1<<17);
+  uint64_t hash = 0, size = 0;
+  while(file) {
+    file.read((char*) buffer.data(), buffer.size()*sizeof(uint64_t));
+    size_t n = file.gcount();
+    //! zero the bytes after the end of the file in the last word
+    if(n % sizeof(uint64_t)) memset((char*) buffer.data() + n, 0, sizeof(uint64_t) - n % sizeof(uint64_t));
+    for(size_t iword = 0; iword < (n+sizeof(uint64_t)-1)/sizeof(uint64_t); iword++) hash = CVHashCombine(hash, buffer[iword]);
+    size += n;
+  }
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) CVHashCombine(hash, size));
+  return hex;
+}
+
+//! summarize one output file of runCVMC into output and add its runs to bands (if not 0), messages go to log
+bool Analyze(const string& filename, const string& outputname, CVOutcomes& o, ostream& log, CVEnsembleBands* bands)
+{
+  TFile* file = TFile::Open(filename.c_str());
+  if(!file || file->IsZombie()) {
+    log << "Error, could not open " << filename << endl;
+    return false;
+  }
+  TTree* population = (TTree*) file->Get("PopulationLevelInformation");
+  TTree* settingsTree = (TTree*) file->Get("settings");
+  TTree* summaryTree = (TTree*) file->Get("runSummary");
+  if(!population || !settingsTree) {
+    log << "Error, " << filename << " has no PopulationLevelInformation or settings tree." << endl;
+    file->Close();
+    return false;
+  }
+  //! the outcomes are summarized over all runs, which must be of the same settings, so the
+  //! runs of several points of a sweep are not mixed
+  if(settingsTree->GetBranch("point")) {
+    int point = 0;
+    set<int> points;
+    settingsTree->SetBranchAddress("point", &point);
+    for(Long64_t irun = 0; irun < settingsTree->GetEntries(); irun++) {
+      settingsTree->GetEntry(irun);
+      points.insert(point);
+    }
+    settingsTree->ResetBranchAddresses();
+    if(points.size() > 1) {
+      log << "Error, " << filename << " has the runs of " << points.size() << " points of a sweep; "
+          << "run the points into separate files or compare them with the point in runSummary." << endl;
+      file->Close();
+      return false;
+    }
+  }
+  //! the settings of every run, in the order of the runs
+  CVRunSettings settings;
+  settings.Connect(settingsTree, false);
+  vector<CVRunSettings> runSettings(settingsTree->GetEntries());
+  for(size_t irun = 0; irun < runSettings.size(); irun++) {
+    settingsTree->GetEntry(irun);
+    runSettings[irun] = settings;
+  }
+  if(runSettings.empty()) {
+    log << "Error, " << filename << " has no runs." << endl;
+    file->Close();
+    return false;
+  }
+  settings = runSettings[0];
+  const int nPersons = settings.nPersons;
+
+  //! outcome of every run ...
+  vector<CVRunSummary> summaries;
+  vector<CVRunIndex>   runs;
+  vector<CVRunCurves>  curves;
+  //! (files written before the doubling time was added to it are read from the daily tree)
+  if(summaryTree && summaryTree->GetBranch("doublingTime") && !gDaily && !gOverview && !bands) {
+    //! ... stored by the simulation
+    CVRunSummary s;
+    summaryTree->SetBranchAddress("fileIndex",           &s.fileIndex);
+    summaryTree->SetBranchAddress("LastDayWithPatients", &s.lastDayWithPatients);
+    summaryTree->SetBranchAddress("startTestingOnDay",   &s.startTestingOnDay);
+    summaryTree->SetBranchAddress("maxDailySick",        &s.maxDailySick);
+    summaryTree->SetBranchAddress("maxQuarantine",       &s.maxQuarantine);
+    summaryTree->SetBranchAddress("maxTotalSick",        &s.maxTotalSick);
+    summaryTree->SetBranchAddress("sickByDay365",        &s.sickByDay365);
+    summaryTree->SetBranchAddress("QuarantineManDays",   &s.quarantineManDays);
+    summaryTree->SetBranchAddress("averageRe",           &s.averageRe);
+    summaryTree->SetBranchAddress("nRe",                 &s.nRe);
+    summaryTree->SetBranchAddress("averageRePre",        &s.averageRePre);
+    summaryTree->SetBranchAddress("nRePre",              &s.nRePre);
+    summaryTree->SetBranchAddress("doublingTime",        &s.doublingTime);
+    for(Long64_t irun = 0; irun < summaryTree->GetEntries(); irun++) {
+      summaryTree->GetEntry(irun);
+      summaries.push_back(s);
+    }
+  }
+  else {
+    //! ... or accumulated from the daily tree, in one pass: the days of all runs are
+    //! concatenated, a new run starts when the index changes or the day restarts
+    CVDayRecord day = {};
+    vector<CVDayRecord> runDays; //! of the current run, for the bands
+    population->SetBranchAddress("fileIndex",             &day.fileIndex);
+    population->SetBranchAddress("day",                   &day.day);
+    population->SetBranchAddress("fNSusceptible",         &day.nSusceptible);
+    population->SetBranchAddress("fNExposed",             &day.nExposed);
+    population->SetBranchAddress("fNInfectious",          &day.nInfectious);
+    population->SetBranchAddress("fNRecovered",           &day.nRecovered);
+    population->SetBranchAddress("fNTraced",              &day.nTraced);
+    population->SetBranchAddress("fNReported",            &day.nReported);
+    population->SetBranchAddress("feffectiveR",           &day.effectiveR);
+    population->SetBranchAddress("feffectiveRUncertainty",&day.effectiveRUncertainty);
+    population->SetBranchAddress("fNQuarantineToday",     &day.nQuarantineToday);
+    CVSummaryAccumulator accumulator;
+    int lastIndex = -1, lastDay = -1, startDay = 0;
+    const Long64_t nEntries = population->GetEntries();
+    for(Long64_t ientry = 0; ientry < nEntries; ientry++) {
+      population->GetEntry(ientry);
+      if(ientry == 0 || day.fileIndex != lastIndex || day.day <= lastDay) {
+        if(runs.size() == runSettings.size()) {
+          log << "Error, " << filename << " has more runs than settings." << endl;
+          file->Close();
+          return false;
+        }
+        if(!runs.empty()) summaries.push_back(accumulator.GetSummary());
+        if(bands && !runs.empty()) bands->AddRun(runDays, runSettings[runs.size()-1].nDays-2);
+        runDays.clear();
+        const CVRunSettings& s = runSettings[runs.size()];
+        accumulator.Reset(day.fileIndex, s.nPersons,
+          CVSummaryAccumulator::GetOutbreakThreshold(s.startTracingTestingInfectedFraction,s.nPersons));
+        startDay = s.startTracingOnDay;
+        runs.push_back({day.fileIndex, ientry, 0});
+        if(gOverview) curves.push_back(CVRunCurves());
+      }
+      runs.back().nEntries++;
+      accumulator.AddDay(day, startDay);
+      if(bands) runDays.push_back(day);
+      if(gOverview) {
+        CVRunCurves& c = curves.back();
+        const double n = runSettings[runs.size()-1].nPersons;
+        c.day.push_back(day.day);
+        c.susceptible.push_back(day.nSusceptible/n);
+        c.sick.push_back((day.nExposed+day.nInfectious)/n);
+        c.reported.push_back(day.nReported/n);
+        c.quarantined.push_back(day.nQuarantineToday/n);
+        c.quarantinedNotSick.push_back(day.nQuarantineToday/n - (n-day.nExposed-day.nInfectious)/n);
+      }
+      lastIndex = day.fileIndex; lastDay = day.day;
+    }
+    if(!runs.empty()) summaries.push_back(accumulator.GetSummary());
+    if(bands && !runs.empty()) bands->AddRun(runDays, runSettings[runs.size()-1].nDays-2);
+  }
+  if(summaries.empty()) {
+    log << "Error, " << filename << " has no days." << endl;
+    file->Close();
+    return false;
+  }
+
+  //! distributions of the outcomes over the runs with an outbreak, as fractions of the population
+  const int nbins = 400;
+  TH1F hMaxDailySick ("hMaxDailySick", ";max sick per day",        nbins,0,1);
+  TH1F hMaxQuarantine("hMaxQuarantine",";max quarantined per day", nbins,0,1);
+  TH1F hMaxTotalSick ("hMaxTotalSick", ";max total sick",          nbins,0,1);
+  TH1F hSick1yr      ("hSick1yr",      "; sick after 1 year",      nbins,0,1);
+  TH1F hQuarantineSum("hQuarantineSum","; quarantined in 1 year",  nbins,0,1);
+  TH1F hRe           ("hRe",           "; hRe",                    nbins,0,10);
+  TH1F hRePre        ("hRePre",        "; hRe",                    nbins,0,10);
+  TH1F hDoublingTime ("hDoublingTime", "; doubling time [days]",   240,-60,60);
+  //! the histograms of the outcomes and, for the intervals, the value of every run in them and
+  //! whether it counts (the statistics of a histogram leave out the values outside its range)
+  enum { H_MaxDailySick, H_MaxQuarantine, H_MaxTotalSick, H_Sick1yr, H_QuarantineSum, H_Re, H_RePre, H_DoublingTime,
+         H_NoOutbreak, H_NoOutbreak50, H_COUNT };
+  TH1F* hists[H_NoOutbreak] = { &hMaxDailySick, &hMaxQuarantine, &hMaxTotalSick, &hSick1yr, &hQuarantineSum, &hRe, &hRePre, &hDoublingTime };
+  const int nRuns = summaries.size();
+  vector<vector<float> > values(H_COUNT, vector<float>(nRuns,0)), counts(H_COUNT, vector<float>(nRuns,0));
+  auto Fill = [&](int ihist, int irun, float x) {
+    hists[ihist]->Fill(x);
+    values[ihist][irun] = x;
+    counts[ihist][irun] = x >= hists[ihist]->GetXaxis()->GetXmin() && x < hists[ihist]->GetXaxis()->GetXmax();
+  };
+  int calculateReFromInterventionStartToDay = CVSummaryAccumulator::kReWindow;
+  int numberSickToCountAsOutbreak = int(settings.startTracingTestingInfectedFraction*float(nPersons));
+  const int outbreakThreshold = CVSummaryAccumulator::GetOutbreakThreshold(settings.startTracingTestingInfectedFraction,nPersons);
+  o.nRuns = summaries.size();
+  o.fractionNoOutbreak = o.fractionNoOutbreak50 = 0;
+  for(int irun = 0; irun < nRuns; irun++) {
+    const CVRunSummary& s = summaries[irun];
+    if(s.maxTotalSick < numberSickToCountAsOutbreak) o.fractionNoOutbreak++;
+    if(s.maxTotalSick < 50) o.fractionNoOutbreak50++;
+    values[H_NoOutbreak][irun]   = s.maxTotalSick < numberSickToCountAsOutbreak;
+    values[H_NoOutbreak50][irun] = s.maxTotalSick < 50;
+    counts[H_NoOutbreak][irun] = counts[H_NoOutbreak50][irun] = 1;
+    if(gVerbose)
+      log << " run " << s.fileIndex << ": maxDailySick " << s.maxDailySick << " maxQuarantine " << s.maxQuarantine
+           << " maxTotalSick " << s.maxTotalSick << " sickByDay365 " << s.sickByDay365
+           << " Re " << s.averageRePre << ", " << s.averageRe << endl;
+    if(s.maxTotalSick <= outbreakThreshold) continue;
+    Fill(H_MaxDailySick,  irun, float(s.maxDailySick)/float(nPersons));
+    Fill(H_MaxQuarantine, irun, float(s.maxQuarantine)/float(nPersons));
+    Fill(H_MaxTotalSick,  irun, float(s.maxTotalSick)/float(nPersons));
+    Fill(H_Sick1yr,       irun, float(s.sickByDay365)/float(nPersons));
+    Fill(H_QuarantineSum, irun, s.quarantineManDays/float(nPersons)/365.);
+    //! runs without a day to average are left out (the macro fills nan)
+    if(s.nRe)    Fill(H_Re,    irun, s.averageRe);
+    if(s.nRePre) Fill(H_RePre, irun, s.averageRePre);
+    if(s.doublingTime != CVGrowthRate::kNoEstimate) Fill(H_DoublingTime, irun, s.doublingTime);
+  }
+  o.fractionNoOutbreak   /= summaries.size();
+  o.fractionNoOutbreak50 /= summaries.size();
+  o.averagemaxdailysick      = hMaxDailySick.GetMean();
+  o.averagemaxdailysickWidth = hMaxDailySick.GetRMS();
+  o.averagemaxq              = hMaxQuarantine.GetMean();
+  o.averagemaxqWidth         = hMaxQuarantine.GetRMS();
+  o.averagemaxtotalsick      = hMaxTotalSick.GetMean();
+  o.averagesickByDay365      = hSick1yr.GetMean();
+  o.averagesickByDay365Width = hSick1yr.GetRMS();
+  o.averageQuarantineManDays      = hQuarantineSum.GetMean();
+  o.averageQuarantineManDaysWidth = hQuarantineSum.GetRMS();
+  o.averageDoublingTime = hDoublingTime.GetMean();
+  o.averageReAfterIntervention      = hRe.GetMean();
+  o.averageReAfterInterventionWidth = hRe.GetRMS();
+  o.averageReBeforeIntervention     = hRePre.GetMean();
+
+  //! confidence intervals of the fields, of the mean or rms of ..
+  static const pair<int,bool> sources[] = {
+    {H_NoOutbreak,false}, {H_NoOutbreak50,false}, {H_MaxDailySick,false}, {H_MaxDailySick,true},
+    {H_MaxQuarantine,false}, {H_MaxQuarantine,true}, {H_MaxTotalSick,false}, {H_Sick1yr,false}, {H_Sick1yr,true},
+    {H_QuarantineSum,false}, {H_QuarantineSum,true}, {H_DoublingTime,false}, {H_Re,false}, {H_Re,true}, {H_RePre,false}
+  };
+  o.intervals.clear();
+  if(gResamples > 0) {
+    CVBootstrap bootstrap(nRuns);
+    for(int ihist = 0; ihist < H_COUNT; ihist++) bootstrap.AddOutcome(values[ihist], counts[ihist]);
+    bootstrap.Run(gResamples, gConfidence, gBootstrapThreads);
+    for(auto& source : sources)
+      o.intervals.push_back(source.second ? bootstrap.GetRMSInterval(source.first) : bootstrap.GetMeanInterval(source.first));
+  }
+
+  if(gOverview) {
+    //! graphics are not thread safe
+    static mutex drawing;
+    lock_guard<mutex> lock(drawing);
+    DrawOverview(filename.substr(filename.rfind('/')+1), file, settings, curves,
+                 {&hMaxDailySick, &hMaxQuarantine, &hMaxTotalSick, &hSick1yr, &hQuarantineSum});
+  }
+  file->Close();
+
+  TFile output(outputname.c_str(),"RECREATE");
+  if(output.IsZombie()) {
+    log << "Error, could not write " << outputname << endl;
+    return false;
+  }
+  TTree* outtree = new TTree("MCSummary","MCSummary tree");
+  auto fields = o.Fields();
+  for(auto& field : fields) outtree->Branch(field.first, field.second);
+  //! <field>Low, <field>High and <field>JackknifeError
+  vector<string> intervalNames;
+  for(size_t ifield = 0; ifield < o.intervals.size(); ifield++) {
+    intervalNames.push_back(string(fields[ifield].first)+"Low");
+    intervalNames.push_back(string(fields[ifield].first)+"High");
+    intervalNames.push_back(string(fields[ifield].first)+"JackknifeError");
+  }
+  for(size_t ifield = 0; ifield < o.intervals.size(); ifield++) {
+    outtree->Branch(intervalNames[3*ifield].c_str(),   &o.intervals[ifield].low);
+    outtree->Branch(intervalNames[3*ifield+1].c_str(), &o.intervals[ifield].high);
+    outtree->Branch(intervalNames[3*ifield+2].c_str(), &o.intervals[ifield].jackknifeError);
+  }
+  outtree->Branch("calculateReFromInterventionStartToDay", &calculateReFromInterventionStartToDay);
+  outtree->Branch("numberSickToCountAsOutbreak",           &numberSickToCountAsOutbreak);
+  settings.Connect(outtree, true);
+  outtree->Fill();
+  outtree->Write();
+  output.Close();
+
+  //! the fields with their intervals as text, Summary_<file>.txt
+  if(!o.intervals.empty()) {
+    string textname = outputname.substr(0, outputname.rfind(".root")) + ".txt";
+    ofstream text(textname);
+    text << "# " << filename << ": " << nRuns << " runs, " << gResamples << " bootstrap resamples, "
+         << gConfidence*100 << "% intervals" << endl;
+    text << "# outcome, value, low, high, jackknife error" << endl;
+    for(size_t ifield = 0; ifield < o.intervals.size(); ifield++)
+      text << fields[ifield].first << ", " << *fields[ifield].second << ", " << o.intervals[ifield].low << ", "
+           << o.intervals[ifield].high << ", " << o.intervals[ifield].jackknifeError << endl;
+    if(!text.good()) log << "Error, could not write " << textname << endl;
+  }
+  log << filename << ": " << summaries.size() << " runs, " << o.fractionNoOutbreak << " without outbreak, Re "
+       << o.averageReBeforeIntervention << " -> " << o.averageReAfterIntervention << endl;
+  return true;
+}
+
+//! the daily curves of every run, the outcome distributions and the settings
+void DrawOverview(const string& name, TFile* file, const CVRunSettings& s,
+                  const vector<CVRunCurves>& curves, const vector<TH1F*>& outcomes)
+{
+  gStyle->SetOptTitle(0);
+  float yoffset = 2.0, xoffset = 2.3;
+  TCanvas tc1("overview","overview",1600,1000);
+  tc1.Divide(2,3);
+  //! graphs of all runs, owned by the canvas pads
+  auto Graph = [](const vector<double>& x, const vector<double>& y, int color) {
+    TGraph* g = new TGraph(x.size(), x.data(), y.data());
+    g->SetLineColor(color); g->SetMarkerColor(color);
+    g->SetBit(TObject::kCanDelete);
+    return g;
+  };
+  tc1.cd(1);
+  TH1F* hdummy = new TH1F("hdummy","; day; Fraction susceptible",10,0,365);
+  hdummy->SetBit(TObject::kCanDelete);
+  hdummy->Draw();
+  hdummy->GetYaxis()->SetRangeUser(0,1.01);
+  hdummy->GetYaxis()->SetTitleOffset(yoffset);
+  hdummy->GetXaxis()->SetTitleOffset(xoffset);
+  for(auto& c : curves) Graph(c.day, c.susceptible, 1)->Draw("samePL");
+
+  tc1.cd(2);
+  TLegend* fl = new TLegend();
+  for(size_t irun = 0; irun < curves.size(); irun++) {
+    TGraph* sick = Graph(curves[irun].day, curves[irun].sick, kOrange-3);
+    TGraph* reported = Graph(curves[irun].day, curves[irun].reported, kBlue+4);
+    if(irun == 0) {
+      sick->GetYaxis()->SetRangeUser(0,0.1);
+      sick->GetYaxis()->SetTitleOffset(yoffset);
+      sick->GetYaxis()->SetTitle("Fraction of population");
+      sick->GetXaxis()->SetTitleOffset(xoffset);
+      sick->Draw("APL");
+      fl->AddEntry(sick, "Sick","PL");
+      fl->AddEntry(reported, "Reported","PL");
+    }
+    else sick->Draw("samePL");
+    reported->Draw("samePL");
+  }
+  fl->SetBit(TObject::kCanDelete);
+  makeLegend(fl, (TPad*) gPad, 0);
+
+  tc1.cd(3);
+  TLegend* fl3 = new TLegend();
+  for(size_t irun = 0; irun < curves.size(); irun++) {
+    TGraph* quarantined = Graph(curves[irun].day, curves[irun].quarantined, kGreen+1);
+    TGraph* notSick = Graph(curves[irun].day, curves[irun].quarantinedNotSick, kCyan+4);
+    quarantined->SetLineWidth(2);
+    if(irun == 0) {
+      quarantined->GetYaxis()->SetTitleOffset(yoffset);
+      quarantined->GetYaxis()->SetTitle("Fraction quarantined");
+      quarantined->GetXaxis()->SetTitleOffset(xoffset);
+      quarantined->Draw("APL");
+      fl3->AddEntry(quarantined, "Quarantined","PL");
+      fl3->AddEntry(notSick, "Quarantined but not sick","PL");
+    }
+    else quarantined->Draw("samePL");
+    notSick->Draw("samePL");
+  }
+  fl3->SetBit(TObject::kCanDelete);
+  makeLegend(fl3, (TPad*) gPad, 0);
+
+  tc1.cd(4);
+  TH1F* hQuarantine = (TH1F*) file->Get("fhDaysToQuarantinePostIntervention");
+  TH1F* hReported   = (TH1F*) file->Get("fhDaysToReportedPostIntervention");
+  TH1F* hTested     = (TH1F*) file->Get("fhDaysToTestedPostIntervention");
+  if(hQuarantine && hReported && hTested) {
+    hQuarantine->SetLineColor(kGreen+1);
+    hReported->SetLineColor(kBlue+4);
+    hTested->SetLineColor(kOrange-3);
+    hQuarantine->GetXaxis()->SetTitleOffset(xoffset);
+    hQuarantine->GetYaxis()->SetTitleOffset(yoffset);
+    hQuarantine->GetYaxis()->SetTitle("Fraction of population");
+    hQuarantine->GetXaxis()->SetTitle("time difference [day]");
+    hQuarantine->DrawCopy("");
+    hReported->DrawCopy("same");
+    hTested->DrawCopy("same");
+    TLegend* fl2 = new TLegend();
+    fl2->AddEntry(hQuarantine, "(Q-I)","FL");
+    fl2->AddEntry(hReported, "(R-E)","FL");
+    fl2->AddEntry(hTested, "(T-E)","FL");
+    fl2->SetBit(TObject::kCanDelete);
+    makeLegend(fl2, (TPad*) gPad, 3);
+  }
+
+  tc1.cd(5);
+  const int colors[] = { kBlue+2, kGreen+1, kRed+1, kOrange+1, kGreen-2 };
+  for(size_t ih = 0; ih < outcomes.size(); ih++) outcomes[ih]->SetLineColor(colors[ih]);
+  outcomes[0]->GetXaxis()->SetTitle("Fraction of population");
+  outcomes[0]->GetXaxis()->SetTitleOffset(xoffset);
+  for(size_t ih = 0; ih < outcomes.size(); ih++) outcomes[ih]->DrawCopy(ih ? "same" : "");
+  TLegend* fl4 = new TLegend();
+  fl4->AddEntry(outcomes[0], "Peak sick same day","FL");
+  fl4->AddEntry(outcomes[1], "Peak quarantine","FL");
+  fl4->AddEntry(outcomes[3], "Total exposed after one year","FL");
+  fl4->AddEntry(outcomes[4], "Average fraction in quarantine","FL");
+  fl4->SetBit(TObject::kCanDelete);
+  makeLegend(fl4, (TPad*) gPad, 0);
+
+  tc1.cd(6);
+  TPaveText* pt = new TPaveText(.05,.01,.5,.9);
+  pt->SetTextAlign(31);
+  pt->SetTextFont(42);
+  pt->AddText(Form("nPersons = %d",s.nPersons));
+  pt->AddText(Form("peopleMetPerDay = %d",int(s.peopleMetPerDay)));
+  pt->AddText(Form("transmissionProbability = %5.4f",s.transmissionProbability));
+  pt->AddText(Form("tracingOrder = %d",s.tracingOrder))->SetTextFont(62);
+  pt->AddText(Form("AppProbability = %3.2f",s.appProbability))->SetTextFont(62);
+  pt->AddText(Form("fTracingEfficiency = %3.2f",s.tracingEfficiency))->SetTextFont(62);
+  pt->AddText(Form("daysToTestResult = %d",s.daysToTestResult))->SetTextFont(62);
+  pt->AddText(Form("symptomProbability = %3.2f",s.symptomProbability))->SetTextFont(62);
+  pt->AddText(Form("dTTest = %d",s.dTTest));
+  pt->AddText(Form("testPositiveProbability = %4.3f",s.testPositiveProbability));
+  pt->AddText(Form("falsePositiveRate = %4.3f",s.falsePositiveRate));
+  pt->SetBit(TObject::kCanDelete);
+  pt->Draw();
+  TPaveText* pt2 = new TPaveText(.5,.1,.95,.8);
+  pt2->SetTextAlign(11);
+  pt2->AddText(Form("backwardTracing = %d",s.backwardTracing));
+  pt2->AddText(Form("traceUninfected = %d",s.traceUninfected));
+  pt2->AddText(Form("daysInQuarantine = %d",s.daysInQuarantine));
+  pt2->AddText(Form("startTTIFraction = %6.5f",s.startTracingTestingInfectedFraction));
+  pt2->AddText(Form("startTracingOnDay = %d",s.startTracingOnDay));
+  pt2->AddText(Form("daysBackwardTrace = %d",s.daysBackwardTrace));
+  pt2->AddText(Form("testThreshold = %4.3f",s.testThreshold));
+  pt2->AddText(Form("incubationGamma = %4.3f",s.incubationGamma));
+  pt2->AddText(Form("incubationMu = %4.3f",s.incubationMu));
+  pt2->AddText(Form("incubationBeta = %4.3f",s.incubationBeta));
+  pt2->AddText(Form("infectionGamma = %4.3f",s.infectionGamma));
+  pt2->AddText(Form("infectionMu = %4.3f",s.infectionMu));
+  pt2->AddText(Form("infectionBeta = %4.3f",s.infectionBeta));
+  pt2->SetBit(TObject::kCanDelete);
+  pt2->Draw();
+  tc1.SaveAs((gOutputDir+"/overview_"+name.substr(0,name.rfind(".root"))+".png").c_str());
+}
+
+void Usage(const char* const exe)
+{
+   cout << "usage: " << exe << " [<options>] rootfile|directory [rootfile|directory ..]\n"
+    "\n"
+    " options:  -o (or --output):   directory for Summary_<rootfile>                   (default: .)\n"
+    "           -j (or --threads):  files summarized at the same time                  (default: 1)\n"
+    "           -c (or --cache):    cache of the outcomes of every file, none for none (default: <output>/analyzeCVMC_cache.json)\n"
+    "           -f (or --force):    summarize all files, also the unchanged ones in the cache\n"
+    "           -p (or --overview): draw the curves of all runs to overview_<rootfile>.png\n"
+    "           -d (or --daily):    use the daily tree even if there is a runSummary tree\n"
+    "           -b (or --bands):    write the mean, rms and 5/50/95% quantiles of the daily census\n"
+    "                               over the runs of all files to this root file (EnsembleBands tree)\n"
+    "           -B (or --resamples):bootstrap resamples of the runs for the intervals, 0 for none (default: " << gResamples << ")\n"
+    "           -C (or --confidence): level of the intervals                           (default: " << gConfidence << ")\n"
+    "           -v (or --verbose):  print the outcome of every run\n"
+   << endl;
+}
+
+int GetOptions(int argc, char** argv)
+{
+   static struct option long_options[] = {
+     {"output",   required_argument, 0,'o'},
+     {"threads",  required_argument, 0,'j'},
+     {"cache",    required_argument, 0,'c'},
+     {"force",    no_argument,       0,'f'},
+     {"overview", no_argument,       0,'p'},
+     {"daily",    no_argument,       0,'d'},
+     {"bands",    required_argument, 0,'b'},
+     {"resamples",required_argument, 0,'B'},
+     {"confidence",required_argument,0,'C'},
+     {"verbose",  no_argument,       0,'v'},
+     {"help",     no_argument,       0,'h'},
+     {0, 0, 0, 0}
+   };
+
+   int option_index = 0;
+   int c;
+   while ((c = getopt_long (argc, argv,
+    ":o:j:c:fpdb:B:C:vh",
+    long_options, &option_index)) != -1) {
+     switch (c) {
+       case 'o': gOutputDir = optarg; break;
+       case 'j': gThreads   = stoi(optarg); break;
+       case 'c': gCache     = optarg; break;
+       case 'f': gForce     = 1;      break;
+       case 'p': gOverview  = 1;      break;
+       case 'd': gDaily     = 1;      break;
+       case 'b': gBands     = optarg; break;
+       case 'B': gResamples = stoi(optarg); break;
+       case 'C': gConfidence = stod(optarg); break;
+       case 'v': gVerbose   = 1;      break;
+       case 'h': return -2;
+       default:  return -2;
+     }
+   }
+   return optind;
+}
@@ -0,0 +1,36 @@
+#!/bin/bash
+# Runs a reference and a candidate runCVMC over the same seeds and compares the outputs
+# statistically with compareCVMC.
+#
+# usage: bench/equivalence.sh <reference exe> <candidate exe> <input json> [nseeds] [alpha] [-- compareCVMC options]
+
+if [ $# -lt 3 ]; then
+  echo "usage: $0 <reference exe> <candidate exe> <input json> [nseeds] [alpha] [-- compareCVMC options]"
+  exit 2
+fi
+
+reference=$(readlink -f "$1")
+candidate=$(readlink -f "$2")
+input=$(readlink -f "$3")
+nseeds=${4:-100}
+alpha=${5:-0.01}
+shift $(( $# < 5 ? $# : 5 ))
+[ "$1" == "--" ] && shift
+compare=$(readlink -f "$(dirname "$0")/../compareCVMC")
+
+workdir=$(mktemp -d -t cvmcequivalence_XXXX)
+trap "rm -rf $workdir" EXIT
+prefix=$(python3 -c "import json,sys; print(json.load(open(sys.argv[1]))['OutputPrefix'])" "$input")
+
+# one process per seed, the seed doubles as run index
+for engine in reference candidate; do
+  exe=${!engine}
+  mkdir -p $workdir/$engine
+  echo "running $engine ($exe) on $nseeds seeds"
+  for seed in $(seq 1 $nseeds); do
+    (cd $workdir/$engine && $exe -s $seed -i $seed "$input" > /dev/null 2>&1) || { echo "$engine failed for seed $seed"; exit 2; }
+  done
+done
+
+list() { ls $workdir/$1/${prefix}_*.root | paste -sd, -; }
+$compare -a $alpha "$@" $(list reference) $(list candidate)
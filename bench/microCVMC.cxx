@@ -0,0 +1,177 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Microbenchmarks of the CVDisease and CVPerson primitives used in the day loop.
+ * Prints per-call latency and throughput, one line per primitive, parameter set and
+ * outbreak length.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+
+//c++
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include "getopt.h"
+
+#include "../CVDisease.h"
+#include "../CVPerson.h"
+
+using namespace std;
+
+int CVPerson::nextId = 0;
+
+//! accessible via optarg
+int    gNCalls      = 200000; //! timed calls per benchmark
+int    gBatch       =     64; //! calls between two (untimed) setups of the state
+string gFilter      =     ""; //! only benchmarks whose name contains this
+
+//! parameter sets of the disease
+struct CVDiseaseParameters {
+  string name;
+  float  symptomProbability, transmissionProbability, testThreshold;
+  float  incubationGamma, incubationMu, incubationBeta;
+  float  infectionGamma,  infectionMu,  infectionBeta;
+};
+const CVDiseaseParameters kParameterSets[] = {
+  //! as in example_input.json
+  { "example", 0.50, 0.064, 0.01, 3.06,  0.00, 2.44, 2.08, -2.42, 1.56 },
+  //! CVDisease defaults
+  { "default", 0.14, 0.064, 0.01, 3.93, -0.99, 2.15, 2.08, -2.42, 1.56 },
+};
+//! short and long outbreaks, the person containers scale with the number of days
+const int kNDays[] = { 100, 1000 };
+
+volatile double gSink = 0; //! keeps the compiler from dropping the calls
+
+void Usage(const char* const exe);
+int  GetOptions(int argc, char** argv);
+
+//! time ncalls of call(i), running setup() untimed before every batch of calls
+void Measure(string name, string parameters, int ndays, function<double(int)> call, function<void()> setup=[](){})
+{
+  if(gFilter != "" && name.find(gFilter) == string::npos) return;
+  typedef chrono::steady_clock Clock;
+  double sum = 0, elapsed = 0;
+  //! warm up
+  setup();
+  for(int icall = 0; icall < gBatch; icall++) sum += call(icall);
+  for(int icall = 0; icall < gNCalls;) {
+    setup();
+    int nbatch = min(gBatch, gNCalls-icall);
+    Clock::time_point start = Clock::now();
+    for(int ibatch = 0; ibatch < nbatch; ibatch++, icall++) sum += call(icall);
+    elapsed += chrono::duration<double,nano>(Clock::now() - start).count();
+  }
+  gSink = gSink + sum;
+  cout << left << setw(24) << name << setw(10) << parameters << right << setw(8) << ndays
+       << fixed << setprecision(1) << setw(14) << elapsed/gNCalls
+       << setprecision(3) << setw(14) << gNCalls/elapsed*1e3 << endl;
+}
+
+int main(int argc, char** argv)
+{
+  //! get option input
+  if(GetOptions(argc, argv) < 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+  cout << left << setw(24) << "primitive" << setw(10) << "params" << right << setw(8) << "nDays"
+       << setw(14) << "ns/call" << setw(14) << "Mcalls/s" << endl;
+
+  //! the generator of the disease and persons, also for TF1::GetRandom
+  TRandom3 random(4357);
+  for(auto parameters : kParameterSets) {
+    CVDisease disease(&random);
+    disease.SetSymptomProbability(parameters.symptomProbability);
+    disease.SetTestThreshold(parameters.testThreshold);
+    disease.SetIncubationParameters(parameters.incubationGamma, parameters.incubationMu, parameters.incubationBeta);
+    disease.SetTransmissionProbability(parameters.transmissionProbability);
+    disease.SetInfectiousnessParameters(parameters.infectionGamma, parameters.infectionMu, parameters.infectionBeta);
+    string name = parameters.name;
+
+    //! disease primitives do not depend on the outbreak length
+    Measure("DrawCourse", name, 0, [&](int) { return disease.DrawCourse().size(); });
+    Measure("GetInfectiousness", name, 0, [&](int i) { return disease.GetInfectiousness(i%25-5, i&1); });
+    Measure("GetTestsPositive", name, 0, [&](int i) { return disease.GetTestsPositive(i%25-5); });
+
+    for(int ndays : kNDays) {
+      CVPerson person(0,ndays,&random);
+      CVPerson infector(1,ndays,&random);
+      infector.Expose(0,&disease);
+      //! exposure on a random day of the first half, including drawing the course
+      Measure("Expose", name, ndays, [&](int i) { person.Expose(i%(ndays/2),&disease); return person.GetRecoveredOn(); },
+              [&]() { person.Reset(); });
+      Measure("ExposeByPerson", name, ndays, [&](int i) { person.Expose(i%(ndays/2),&infector); return person.GetRecoveredOn(); },
+              [&]() { person.Reset(); infector.ClearExposed(); infector.ClearDays(); });
+      //! the containers are reset between batches so that every call does the full work
+      Measure("Quarantine", name, ndays, [&](int i) { return person.Quarantine((i*7)%(ndays-14),14); },
+              [&]() { person.Reset(); person.Expose(0,&disease); });
+      Measure("ReleaseFromQuarantine", name, ndays, [&](int i) { int day = (i*7)%(ndays-14); person.Quarantine(day,14); return person.ReleaseFromQuarantine(day,14); },
+              [&]() { person.Reset(); person.Expose(0,&disease); });
+      Measure("Trace", name, ndays, [&](int i) { int day = (i*7)%(ndays-14); return person.Trace(day,day+14); },
+              [&]() { person.Reset(); person.Expose(0,&disease); });
+      Measure("Report", name, ndays, [&](int) { return person.Report(person.GetExposedOn(),14); },
+              [&]() { person.Reset(); person.Expose(random.Integer(ndays/2),&disease); });
+      Measure("PersonGetTestsPositive", name, ndays, [&](int i) { return person.GetTestsPositive(i%ndays); },
+              [&]() { person.Reset(); person.Expose(random.Integer(ndays/2),&disease); });
+      Measure("Reset", name, ndays, [&](int) { person.Reset(); return person.GetExposedOn(); });
+    }
+  }
+  return 0;
+}
+
+void Usage(const char* const exe)
+{
+   cout << "usage: " << exe << " [<options>] \n"
+    "\n"
+    " options:  -n (or --ncalls):   timed calls per benchmark     (default: " << gNCalls << ")\n"
+    "           -b (or --batch):    calls between state resets    (default: " << gBatch  << ")\n"
+    "           -f (or --filter):   only primitives matching      (default: all)\n"
+   << endl;
+}
+
+int GetOptions(int argc, char** argv)
+{
+   static struct option long_options[] = {
+     {"ncalls",  required_argument, 0,'n'},
+     {"batch",   required_argument, 0,'b'},
+     {"filter",  required_argument, 0,'f'},
+     {"help",    no_argument,       0,'h'},
+     {0, 0, 0, 0}
+   };
+
+   int option_index = 0;
+   int c;
+   while ((c = getopt_long (argc, argv,
+    ":n:b:f:h",
+    long_options, &option_index)) != -1) {
+     switch (c) {
+       case 'n': gNCalls = stoi(optarg); break;
+       case 'b': gBatch  = stoi(optarg); break;
+       case 'f': gFilter = optarg;       break;
+       case 'h': return -2;
+       default:  return -2;
+     }
+   }
+   return optind;
+}
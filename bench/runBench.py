@@ -0,0 +1,148 @@
+'''
+Runs the benchmark scenarios listed in bench/scenarios.json with fixed seeds and
+reports wall time, runs/sec, peak RSS and the per-phase breakdown of runCVMC -t as json.
+Exits with 1 if a scenario exceeds its budget.
+
+usage: python3 bench/runBench.py [--exe ./runCVMC] [--scenario name ...] [--seeds 1 2 3]
+                                 [--all] [--output result.json]
+'''
+import argparse
+import json
+import os
+import resource
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+import traceback
+
+
+benchdir = os.path.dirname(os.path.abspath(__file__))
+
+'''
+Parse the "PerformanceInformation key=value ..." line that runCVMC -t prints per run
+'''
+def ParsePerformance(stdout):
+	runs = []
+	for line in stdout.splitlines():
+		if not line.startswith("PerformanceInformation"):
+			continue
+		values = {}
+		for item in line.split()[1:]:
+			key, value = item.split("=")
+			values[key] = float(value)
+		runs.append(values)
+	return runs
+
+'''
+Run one scenario once per seed, each seed in a fresh runCVMC process
+'''
+def RunScenario(exe, scenario, seeds, workdir):
+	inputfile = os.path.join(benchdir, scenario["input"])
+	walltimes = []
+	phases = {}
+	residentmemory = []
+	for seed in seeds:
+		start = time.time()
+		process = subprocess.Popen([exe, "-t", "-s", str(seed), "-i", str(seed), inputfile],
+		                           cwd=workdir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+		stdout = process.communicate()[0]
+		walltimes.append(time.time() - start)
+		if process.returncode != 0:
+			sys.stderr.write("%s seed %d failed:\n%s\n" % (scenario["name"], seed, stdout[-2000:]))
+			return None
+		for run in ParsePerformance(stdout):
+			residentmemory.append(run.pop("residentMemory", 0) / 1024.)
+			for key, value in run.items():
+				if key != "fileIndex":
+					phases[key] = phases.get(key, 0.) + value
+	# ru_maxrss of the children is the maximum over all finished children [kB on linux]
+	peakrss = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss / 1024.
+	nruns = len(seeds)
+	result = {
+		"name":        scenario["name"],
+		"input":       scenario["input"],
+		"seeds":       seeds,
+		"wallTime":    sum(walltimes),
+		"wallTimeMean": sum(walltimes) / nruns,
+		"wallTimeMin": min(walltimes),
+		"wallTimeMax": max(walltimes),
+		"runsPerSec":  nruns / sum(walltimes),
+		"peakRSSMB":   peakrss,
+		"endOfRunRSSMB": max(residentmemory) if residentmemory else None,
+		"phases":      dict((key, value / nruns) for key, value in phases.items()),
+		"budget":      scenario.get("budget"),
+		"maxRSS":      scenario.get("maxRSS"),
+	}
+	result["overBudget"] = (result["budget"] is not None and result["wallTimeMean"] > result["budget"]) or \
+	                       (result["maxRSS"] is not None and peakrss > result["maxRSS"])
+	return result
+
+
+def main():
+	parser = argparse.ArgumentParser(description="runCVMC benchmark driver")
+	parser.add_argument("--exe", default=os.path.join(benchdir, "..", "runCVMC"), help="runCVMC executable")
+	parser.add_argument("--scenario", nargs="+", help="only run these scenarios")
+	parser.add_argument("--seeds", nargs="+", type=int, help="override the seeds of scenarios.json")
+	parser.add_argument("--all", action="store_true", help="also run the optional (very large) scenarios")
+	parser.add_argument("--output", help="write the json result to this file instead of std out")
+	args = parser.parse_args()
+
+	config = json.load(open(os.path.join(benchdir, "scenarios.json")))
+	seeds = args.seeds if args.seeds else config["seeds"]
+	exe = os.path.abspath(args.exe)
+	results = []
+	failed = False
+	for scenario in config["scenarios"]:
+		if args.scenario and scenario["name"] not in args.scenario:
+			continue
+		if scenario.get("optional", False) and not args.all and not args.scenario:
+			continue
+		sys.stderr.write("running %s ...\n" % scenario["name"])
+		# every scenario runs in a forked driver and its own directory, as the peak RSS of the children can only grow
+		workdir = tempfile.mkdtemp(prefix="cvmcbench_")
+		pid = os.fork()
+		resultfile = os.path.join(workdir, "result.json")
+		if pid == 0:
+			# the driver always leaves a result, null if the scenario failed
+			result, status = None, 1
+			try:
+				result = RunScenario(exe, scenario, seeds, workdir)
+				status = 0 if result is not None else 1
+			except Exception:
+				traceback.print_exc()
+			finally:
+				try:
+					with open(resultfile, "w") as fout:
+						json.dump(result, fout)
+				finally:
+					os._exit(status)
+		status = os.waitpid(pid, 0)[1]
+		result = None
+		try:
+			with open(resultfile) as fin:
+				result = json.load(fin)
+		except (IOError, ValueError):
+			pass
+		shutil.rmtree(workdir, ignore_errors=True)
+		if status != 0 or result is None:
+			sys.stderr.write("%s failed\n" % scenario["name"])
+			failed = True
+			continue
+		if result["overBudget"]:
+			sys.stderr.write("%s is over budget: %.2f s per run (budget %s s), %.0f MB (max %s MB)\n" %
+			                 (result["name"], result["wallTimeMean"], result["budget"], result["peakRSSMB"], result["maxRSS"]))
+			failed = True
+		results.append(result)
+
+	text = json.dumps({"exe": exe, "seeds": seeds, "scenarios": results}, indent=2)
+	if args.output:
+		open(args.output, "w").write(text + "\n")
+	else:
+		print(text)
+	return 1 if failed else 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
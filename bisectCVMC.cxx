@@ -0,0 +1,240 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Find the first day on which two simulations with the same seed diverge, from the
+ * StateHash trees written by runCVMC -H. As the state hash of a day includes all previous
+ * days, the first diverging day is found by bisection; the block hashes of that day then
+ * point to the persons whose state differs.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+
+//c++
+#include <vector>
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include "getopt.h"
+
+//root
+#include <TFile.h>
+#include <TTree.h>
+
+using namespace std;
+
+//! accessible via optarg
+int gRun       = -1; //! only this run (-1=all runs)
+int gMaxBlocks = 10; //! print at most .. diverging blocks
+
+//! the state hashes of one output file
+struct CVHashFile {
+  string    name;
+  TFile*    file;
+  TTree*    tree;
+  int       nPersons;
+  int       nBlocks;
+  map<int, vector<Long64_t> >  entries; //! run -> tree entry of each day
+  map<int, vector<int> >       days;    //! run -> day of each entry
+  map<int, vector<ULong64_t> > hashes;  //! run -> rolling hash of each entry
+};
+
+void Usage(const char* const exe);
+int  GetOptions(int argc, char** argv);
+bool ReadHashFile(string filename, CVHashFile& hashFile);
+vector<ULong64_t> ReadBlockHashes(CVHashFile& hashFile, Long64_t entry);
+bool CompareRun(CVHashFile& reference, CVHashFile& candidate, int run);
+
+int main(int argc, char** argv)
+{
+  //! get option input
+  const int nOptions = GetOptions(argc, argv);
+  if(nOptions < 0 || argc - nOptions < 2) {
+    Usage(argv[0]);
+    return 2;
+  };
+  CVHashFile reference, candidate;
+  if(!ReadHashFile(argv[nOptions],reference) || !ReadHashFile(argv[nOptions+1],candidate)) return 2;
+  if(reference.nPersons != candidate.nPersons) {
+    cout << "Error, the files simulate " << reference.nPersons << " and " << candidate.nPersons << " persons." << endl;
+    return 2;
+  }
+  if(reference.nBlocks != candidate.nBlocks) {
+    cout << "Error, the files were hashed with " << reference.nBlocks << " and " << candidate.nBlocks << " blocks, rerun with equal -H." << endl;
+    return 2;
+  }
+  //! compare the runs present in both files
+  int ncompared = 0, ndiverged = 0;
+  for(auto& kv : reference.entries) {
+    int run = kv.first;
+    if(gRun > -1 && run != gRun) continue;
+    if(!candidate.entries.count(run)) { 
+      cout << "run " << run << ": not in " << candidate.name << endl; 
+      continue; 
+    }
+    ncompared++;
+    if(!CompareRun(reference,candidate,run)) ndiverged++;
+  }
+  if(ncompared == 0) {
+    cout << "Error, no common runs to compare." << endl;
+    return 2;
+  }
+  cout << ndiverged << " of " << ncompared << " runs diverge" << endl;
+  return ndiverged > 0 ? 1 : 0;
+}
+
+//! read index, day and rolling hash of every entry; the block hashes are only read when needed
+bool ReadHashFile(string filename, CVHashFile& hashFile)
+{
+  hashFile.name = filename;
+  hashFile.file = TFile::Open(filename.c_str());
+  if(!hashFile.file) {
+    cout << "Error, could not open " << filename << endl;
+    return false;
+  }
+  hashFile.tree = (TTree*) hashFile.file->Get("StateHash");
+  if(!hashFile.tree || hashFile.tree->GetEntries() == 0) {
+    cout << "Error, no StateHash tree in " << filename << ", run runCVMC with -H." << endl;
+    return false;
+  }
+  TTree* settings = (TTree*) hashFile.file->Get("settings");
+  hashFile.nPersons = 0;
+  if(settings) {
+    settings->SetBranchAddress("nPersons",&hashFile.nPersons);
+    settings->GetEntry(0);
+  }
+  int run, day;
+  ULong64_t hash;
+  TTree* tree = hashFile.tree;
+  tree->SetBranchStatus("*",0);
+  for(auto branch : { "fileIndex", "day", "hash", "nBlocks" }) tree->SetBranchStatus(branch,1);
+  tree->SetBranchAddress("fileIndex",&run);
+  tree->SetBranchAddress("day",&day);
+  tree->SetBranchAddress("hash",&hash);
+  tree->SetBranchAddress("nBlocks",&hashFile.nBlocks);
+  for(Long64_t ientry = 0; ientry < tree->GetEntries(); ientry++) {
+    tree->GetEntry(ientry);
+    hashFile.entries[run].push_back(ientry);
+    hashFile.days[run].push_back(day);
+    hashFile.hashes[run].push_back(hash);
+  }
+  return true;
+}
+
+vector<ULong64_t> ReadBlockHashes(CVHashFile& hashFile, Long64_t entry)
+{
+  vector<ULong64_t> blocks(hashFile.nBlocks);
+  if(hashFile.nBlocks < 1) return blocks;
+  hashFile.tree->SetBranchStatus("blockHash",1);
+  hashFile.tree->SetBranchAddress("blockHash",&blocks[0]);
+  hashFile.tree->GetEntry(entry);
+  hashFile.tree->SetBranchStatus("blockHash",0);
+  return blocks;
+}
+
+//! print the first diverging day of a run and the persons on it, return true if the runs are identical
+bool CompareRun(CVHashFile& reference, CVHashFile& candidate, int run)
+{
+  vector<int>&       refDays  = reference.days[run];
+  vector<int>&       candDays = candidate.days[run];
+  vector<ULong64_t>& refHash  = reference.hashes[run];
+  vector<ULong64_t>& candHash = candidate.hashes[run];
+  int nentries = min(refHash.size(),candHash.size());
+  //! the hash of a day depends on all days before, so once diverged the hashes stay different
+  int first = 0, last = nentries;
+  while(first < last) {
+    int middle = (first+last)/2;
+    if(refDays[middle] == candDays[middle] && refHash[middle] == candHash[middle]) first = middle+1;
+    else last = middle;
+  }
+  if(first == nentries) {
+    if(refHash.size() == candHash.size()) {
+      cout << "run " << run << ": identical on all " << nentries << " days" << endl;
+      return true;
+    }
+    cout << "run " << run << ": identical up to day " << refDays[nentries-1] << ", the outbreak ends on day "
+         << refDays.back() << " in " << reference.name << " and on day " << candDays.back() << " in " << candidate.name << endl;
+    return false;
+  }
+  int day = refDays[first];
+  cout << "run " << run << ": first diverging day " << day;
+  if(first > 0) cout << " (identical up to day " << refDays[first-1] << ")";
+  cout << endl;
+  if(candDays[first] != day) {
+    cout << "  the runs record different days (" << day << " and " << candDays[first] << ")" << endl;
+    return false;
+  }
+  //! find the blocks of persons that differ on this day
+  if(reference.nBlocks < 1) {
+    cout << "  hashed without person blocks, rerun with -H <blocks> to find the persons" << endl;
+    return false;
+  }
+  vector<ULong64_t> refBlocks  = ReadBlockHashes(reference,reference.entries[run][first]);
+  vector<ULong64_t> candBlocks = ReadBlockHashes(candidate,candidate.entries[run][first]);
+  int nBlocks = reference.nBlocks, nPersons = reference.nPersons, ndiffer = 0;
+  for(int iblock = 0; iblock < nBlocks; iblock++) {
+    if(refBlocks[iblock] == candBlocks[iblock]) continue;
+    if(ndiffer++ >= gMaxBlocks) continue;
+    //! same partition as CVMC::HashDay
+    long firstPerson = long(iblock)*nPersons/nBlocks, lastPerson = long(iblock+1)*nPersons/nBlocks-1;
+    if(firstPerson == lastPerson) cout << "  person " << firstPerson << " differs" << endl;
+    else cout << "  persons " << firstPerson << "-" << lastPerson << " (block " << iblock << ") differ" << endl;
+  }
+  if(ndiffer > gMaxBlocks) cout << "  ... " << ndiffer << " of " << nBlocks << " blocks differ" << endl;
+  if(ndiffer == 0) cout << "  all persons agree, the population counters differ" << endl;
+  else cout << "  see readCVEvents -r " << run << " -f " << day << " -l " << day << " -p <person> on the event files of both runs" << endl;
+  return false;
+}
+
+void Usage(const char* const exe)
+{
+   cout << "usage: " << exe << " [<options>] reference.root candidate.root \n"
+    "\n"
+    " Both files need the StateHash tree (runCVMC -H <blocks>); use as many blocks as persons\n"
+    " to find the single diverging persons.\n"
+    "\n"
+    " options:  -r (or --run):      only this run                 (default: all)\n"
+    "           -b (or --blocks):   print at most .. blocks       (default: " << gMaxBlocks << ")\n"
+   << endl;
+}
+
+int GetOptions(int argc, char** argv)
+{
+   static struct option long_options[] = {
+     {"run",     required_argument, 0,'r'},
+     {"blocks",  required_argument, 0,'b'},
+     {"help",    no_argument,       0,'h'},
+     {0, 0, 0, 0}
+   };
+
+   int option_index = 0;
+   int c;
+   while ((c = getopt_long (argc, argv,
+    ":r:b:h",
+    long_options, &option_index)) != -1) {
+     switch (c) {
+       case 'r': gRun       = stoi(optarg); break;
+       case 'b': gMaxBlocks = stoi(optarg); break;
+       case 'h': return -2;
+       default:  return -2;
+     }
+   }
+   return optind;
+}
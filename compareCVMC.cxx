@@ -0,0 +1,334 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Statistical comparison of the output of two simulation engines.
+ * The runs of a reference and a candidate are compared day by day (S/E/I/R distributions
+ * over runs, Kolmogorov-Smirnov), by the diagnostic fh* histograms (chi-square) and by the
+ * summary outcomes of CVPostProcess (Kolmogorov-Smirnov). The engines are called equivalent
+ * if no test fails at the given significance after Bonferroni correction.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+
+//c++
+#include <vector>
+#include <map>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include "getopt.h"
+
+//root
+#include <TMath.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1F.h>
+#include <TString.h>
+
+using namespace std;
+
+//! accessible via optarg
+float gAlpha      = 0.01;  //! family-wise significance
+int   gDayStep    =     7; //! compare the daily distributions every .. days
+bool  gBonferroni =  true; //! correct alpha for the number of tests
+bool  gVerbose    = false; //! print every test, not only failures
+
+//! the diagnostic histograms written by CVMC::WriteROOTFile
+const char* const kHistogramNames[] = {
+  "fhIncubationPeriod", "fhInfectiousness", "fhLatentPeriod",
+  "fhInfectiousnessAgeSymptom", "fhInfectiousnessAgeNoSymptom",
+  "fhInfectiousnessDurationSymptom", "fhInfectiousnessDurationNoSymptom",
+  "fhDaysToQuarantinePostIntervention", "fhDaysToQuarantinePreIntervention",
+  "fhDaysToReportedPostIntervention", "fhDaysToReportedPreIntervention",
+  "fhDaysToTestedPostIntervention", "fhDaysToTestedPreIntervention",
+  "fhNumberInfectedPreIntervention"
+};
+const int kNHistograms = sizeof(kHistogramNames)/sizeof(kHistogramNames[0]);
+
+//! summary outcomes, as defined in CVPostProcess
+const char* const kMetricNames[] = {
+  "maxDailySick", "maxQuarantine", "maxTotalSick", "sick1yr", "quarantineSum", "ReAfterIntervention", "ReBeforeIntervention"
+};
+const int kNMetrics = sizeof(kMetricNames)/sizeof(kMetricNames[0]);
+
+//! daily curves of one run
+struct CVRunCurves {
+  int nPersons;
+  int startDay;  //! start of interventions
+  vector<int> S, E, I, R, Q;
+  vector<float> Re;
+};
+
+//! everything read from one side of the comparison
+struct CVSample {
+  vector<CVRunCurves> runs;
+  TH1F* histograms[kNHistograms];      //! summed over all files
+  vector<TH1F*> fileHistograms[kNHistograms]; //! per file
+};
+
+//! a single test
+struct CVTest {
+  string name;
+  string method;
+  double p;
+};
+
+void Usage(const char* const exe);
+int  GetOptions(int argc, char** argv);
+bool ReadSample(string files, CVSample& sample, string label);
+vector<double> GetMetric(const vector<CVRunCurves>& runs, int imetric);
+double KSTest(vector<double> a, vector<double> b);
+double HistogramTest(CVSample& a, CVSample& b, int ihist);
+
+int main(int argc, char** argv)
+{
+  //! get option input
+  const int nOptions = GetOptions(argc, argv);
+  if(nOptions < 0 || argc - nOptions < 2) {
+    Usage(argv[0]);
+    return 2;
+  };
+  CVSample reference, candidate;
+  if(!ReadSample(argv[nOptions],  reference,"ref")  || !ReadSample(argv[nOptions+1],candidate,"cand")) return 2;
+  cout << "reference: " << reference.runs.size() << " runs, candidate: " << candidate.runs.size() << " runs" << endl;
+  if(reference.runs.size() < 2 || candidate.runs.size() < 2) {
+    cout << "Error, need at least two runs on each side." << endl;
+    return 2;
+  }
+  vector<CVTest> tests;
+
+  //! daily S/E/I/R distributions over runs; finished runs keep their last state
+  int lastDay = 0;
+  for(auto& run : reference.runs) lastDay = max(lastDay,(int) run.S.size()-1);
+  for(auto& run : candidate.runs) lastDay = max(lastDay,(int) run.S.size()-1);
+  const char* compartments[4] = { "S", "E", "I", "R" };
+  for(int iday = 0; iday <= lastDay; iday += gDayStep) {
+    for(int icomp = 0; icomp < 4; icomp++) {
+      vector<double> values[2];
+      CVSample* samples[2] = { &reference, &candidate };
+      for(int iside = 0; iside < 2; iside++) {
+        for(auto& run : samples[iside]->runs) {
+          vector<int>& curve = icomp == 0 ? run.S : icomp == 1 ? run.E : icomp == 2 ? run.I : run.R;
+          if(curve.empty()) continue;
+          values[iside].push_back(curve.at(min(iday,(int) curve.size()-1))/double(run.nPersons));
+      } }
+      double p = KSTest(values[0],values[1]);
+      if(p >= 0) tests.push_back({ Form("day %d %s",iday,compartments[icomp]), "KS", p });
+  } }
+
+  //! diagnostic histograms
+  for(int ihist = 0; ihist < kNHistograms; ihist++) {
+    double p = HistogramTest(reference,candidate,ihist);
+    if(p >= 0) tests.push_back({ kHistogramNames[ihist], "chi2", p });
+  }
+
+  //! summary outcomes
+  for(int imetric = 0; imetric < kNMetrics; imetric++) {
+    double p = KSTest(GetMetric(reference.runs,imetric),GetMetric(candidate.runs,imetric));
+    if(p >= 0) tests.push_back({ kMetricNames[imetric], "KS", p });
+  }
+
+  //! verdict
+  double threshold = gBonferroni && tests.size() > 0 ? gAlpha/tests.size() : gAlpha;
+  int nfailed = 0;
+  for(auto& test : tests) {
+    bool failed = test.p < threshold;
+    if(failed) nfailed++;
+    if(failed || gVerbose)
+      cout << Form("%-40s %-5s p = %-10.4g %s", test.name.c_str(), test.method.c_str(), test.p, failed ? "FAIL" : "ok") << endl;
+  }
+  cout << Form("%d tests, %d failed at p < %.3g (alpha %.3g%s)", (int) tests.size(), nfailed, threshold, gAlpha, gBonferroni ? ", Bonferroni" : "") << endl;
+  cout << (nfailed == 0 ? "EQUIVALENT" : "NOT EQUIVALENT") << endl;
+  return nfailed == 0 ? 0 : 1;
+}
+
+//! read the runs and the summed histograms from a comma separated list of files
+bool ReadSample(string files, CVSample& sample, string label)
+{
+  for(int ihist = 0; ihist < kNHistograms; ihist++) sample.histograms[ihist] = 0;
+  stringstream list(files);
+  string filename;
+  while(getline(list,filename,',')) {
+    TFile* fin = new TFile(filename.c_str());
+    if(!fin->IsOpen()) { cout << "Error, cannot open " << filename << endl; return false; }
+    TTree* population = (TTree*) fin->Get("PopulationLevelInformation");
+    TTree* settings   = (TTree*) fin->Get("settings");
+    if(!population || !settings) { cout << "Error, " << filename << " is not a CVMC output file." << endl; return false; }
+
+    int fileIndex, day, nSusceptible, nExposed, nInfectious, nRecovered, nQuarantine;
+    float effectiveR;
+    population->SetBranchAddress("fileIndex",&fileIndex);
+    population->SetBranchAddress("day",&day);
+    population->SetBranchAddress("fNSusceptible",&nSusceptible);
+    population->SetBranchAddress("fNExposed",&nExposed);
+    population->SetBranchAddress("fNInfectious",&nInfectious);
+    population->SetBranchAddress("fNRecovered",&nRecovered);
+    population->SetBranchAddress("fNQuarantineToday",&nQuarantine);
+    population->SetBranchAddress("feffectiveR",&effectiveR);
+    int nPersons, startDay;
+    settings->SetBranchAddress("nPersons",&nPersons);
+    settings->SetBranchAddress("startTracingOnDay",&startDay);
+
+    //! the days of all runs are concatenated; a new run starts when the index changes or the day restarts
+    int firstRun = sample.runs.size();
+    int lastIndex = -1, lastDay = -1;
+    for(int ientry = 0; ientry < population->GetEntries(); ientry++) {
+      population->GetEntry(ientry);
+      if(ientry == 0 || fileIndex != lastIndex || day <= lastDay) {
+        settings->GetEntry(sample.runs.size() - firstRun);
+        sample.runs.push_back(CVRunCurves());
+        sample.runs.back().nPersons = nPersons;
+        sample.runs.back().startDay = startDay;
+      }
+      CVRunCurves& run = sample.runs.back();
+      run.S.push_back(nSusceptible);
+      run.E.push_back(nExposed);
+      run.I.push_back(nInfectious);
+      run.R.push_back(nRecovered);
+      run.Q.push_back(nQuarantine);
+      run.Re.push_back(effectiveR);
+      lastIndex = fileIndex; lastDay = day;
+    }
+    //! add up the histograms
+    for(int ihist = 0; ihist < kNHistograms; ihist++) {
+      TH1F* hist = (TH1F*) fin->Get(kHistogramNames[ihist]);
+      if(!hist) continue;
+      sample.fileHistograms[ihist].push_back(hist);
+      if(!sample.histograms[ihist]) sample.histograms[ihist] = (TH1F*) hist->Clone(Form("%s_%s",kHistogramNames[ihist],label.c_str()));
+      else sample.histograms[ihist]->Add(hist);
+    }
+  }
+  return true;
+}
+
+//! summary outcome of each run, as in CVPostProcess. Runs without a defined value are skipped.
+vector<double> GetMetric(const vector<CVRunCurves>& runs, int imetric)
+{
+  const int calculateReFromInterventionStartToDay = 28;
+  vector<double> values;
+  for(auto& run : runs) {
+    double N = run.nPersons;
+    double maxdailysick = 0, maxq = 0, sickByDay365 = 0, quarantineSum = 0, avgRe = 0, avgRePre = 0;
+    int recounter = 0, reprecounter = 0;
+    for(int iday = 0; iday < (int) run.S.size(); iday++) {
+      int totalsick = run.nPersons - run.S[iday];
+      maxdailysick = max(maxdailysick,double(run.E[iday]+run.I[iday]));
+      maxq = max(maxq,double(run.Q[iday]));
+      if(iday <= 365+run.startDay) sickByDay365 = totalsick;
+      if(iday > run.startDay && iday < 365+run.startDay) quarantineSum += run.Q[iday];
+      if(iday > run.startDay+10 && iday < run.startDay+calculateReFromInterventionStartToDay && run.Re[iday] > -1 && totalsick < N/2.) { avgRe += run.Re[iday]; recounter++; }
+      if(iday > run.startDay-calculateReFromInterventionStartToDay/2 && iday < run.startDay-1 && run.Re[iday] > -1) { avgRePre += run.Re[iday]; reprecounter++; }
+    }
+    switch(imetric) {
+      case 0: values.push_back(maxdailysick/N); break;
+      case 1: values.push_back(maxq/N); break;
+      case 2: values.push_back((run.nPersons-run.S.back())/N); break;
+      case 3: values.push_back(sickByDay365/N); break;
+      case 4: values.push_back(quarantineSum/N/365.); break;
+      case 5: if(recounter    > 0) values.push_back(avgRe/recounter);       break;
+      case 6: if(reprecounter > 0) values.push_back(avgRePre/reprecounter); break;
+      default: break;
+    }
+  }
+  return values;
+}
+
+//! Every file holds histograms normalized per run, so the spread between runs dominates the
+//! bin errors. With several files per side, compare the bin means over files with their
+//! observed variance; otherwise fall back to the weighted chi-square test of the sums.
+double HistogramTest(CVSample& a, CVSample& b, int ihist)
+{
+  TH1F* ha = a.histograms[ihist];
+  TH1F* hb = b.histograms[ihist];
+  if(!ha || !hb || ha->Integral() <= 0 || hb->Integral() <= 0) return -1;
+  vector<TH1F*>& fa = a.fileHistograms[ihist];
+  vector<TH1F*>& fb = b.fileHistograms[ihist];
+  if(fa.size() < 2 || fb.size() < 2) return ha->Chi2Test(hb,"WW");
+  double chi2 = 0;
+  int ndf = 0;
+  for(int ibin = 1; ibin <= ha->GetNbinsX(); ibin++) {
+    double mean[2] = {0,0}, var[2] = {0,0};
+    vector<TH1F*>* files[2] = { &fa, &fb };
+    for(int iside = 0; iside < 2; iside++) {
+      double n = files[iside]->size();
+      for(auto hist : *files[iside]) mean[iside] += hist->GetBinContent(ibin)/n;
+      for(auto hist : *files[iside]) var[iside]  += TMath::Power(hist->GetBinContent(ibin)-mean[iside],2)/(n-1);
+      var[iside] /= n;
+    }
+    if(var[0]+var[1] <= 0) continue;
+    chi2 += TMath::Power(mean[0]-mean[1],2)/(var[0]+var[1]);
+    ndf++;
+  }
+  if(ndf == 0) return 1;
+  return TMath::Prob(chi2,ndf);
+}
+
+//! two-sample Kolmogorov-Smirnov test, -1 if not enough entries
+double KSTest(vector<double> a, vector<double> b)
+{
+  if(a.size() < 2 || b.size() < 2) return -1;
+  sort(a.begin(),a.end());
+  sort(b.begin(),b.end());
+  //! identical constant samples (e.g. all runs fizzled) agree trivially
+  if(a.front() == a.back() && b.front() == b.back() && a.front() == b.front()) return 1;
+  return TMath::KolmogorovTest(a.size(),&a[0],b.size(),&b[0],"");
+}
+
+void Usage(const char* const exe)
+{
+   cout << "usage: " << exe << " [<options>] reference.root[,more.root..] candidate.root[,more.root..] \n"
+    "\n"
+    " options:  -a (or --alpha):    family-wise significance      (default: " << gAlpha   << ")\n"
+    "           -s (or --daystep):  compare daily curves every .. (default: " << gDayStep << ")\n"
+    "           -n (or --nocorrection): no Bonferroni correction \n"
+    "           -v (or --verbose):  print all tests \n"
+    "\n"
+    " exit code 0 if equivalent, 1 if not, 2 on error\n"
+   << endl;
+}
+
+int GetOptions(int argc, char** argv)
+{
+   static struct option long_options[] = {
+     {"alpha",        required_argument, 0,'a'},
+     {"daystep",      required_argument, 0,'s'},
+     {"nocorrection", no_argument,       0,'n'},
+     {"verbose",      no_argument,       0,'v'},
+     {"help",         no_argument,       0,'h'},
+     {0, 0, 0, 0}
+   };
+
+   int option_index = 0;
+   int c;
+   while ((c = getopt_long (argc, argv,
+    ":a:s:nvh",
+    long_options, &option_index)) != -1) {
+     switch (c) {
+       case 'a': gAlpha      = stof(optarg); break;
+       case 's': gDayStep    = max(1,stoi(optarg)); break;
+       case 'n': gBonferroni = false;        break;
+       case 'v': gVerbose    = true;         break;
+       case 'h': return -2;
+       default:  return -2;
+     }
+   }
+   return optind;
+}
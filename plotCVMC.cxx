@@ -0,0 +1,157 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Draw the diagnostic canvas of runCVMC from an output file, e.g. one written with -g
+ * (no graphics). The disease functions are rebuilt from the settings tree, the histograms
+ * are the stored ones, averaged over the runs in the file.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+
+//c++
+#include <iostream>
+#include "getopt.h"
+
+//root
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include "CVDiagnostics.h"
+
+using namespace std;
+
+//! accessible via optarg
+int    gRun    = -1; //! disease settings of this run (-1=first run in the file)
+string gOutput = ""; //! pdf, png, .. or root file (default: <file>_diagnostic.pdf)
+
+void Usage(const char* const exe);
+int  GetOptions(int argc, char** argv);
+
+int main(int argc, char** argv)
+{
+  //! get option input
+  const int nOptions = GetOptions(argc, argv);
+  if(nOptions < 0 || argc - nOptions < 1) {
+    Usage(argv[0]);
+    return 1;
+  };
+  string filename = argv[nOptions];
+  if(gOutput == "") gOutput = filename.substr(0,filename.rfind(".root")) + "_diagnostic.pdf";
+  gROOT->SetBatch();
+
+  TFile* file = TFile::Open(filename.c_str());
+  if(!file || file->IsZombie()) {
+    cout << "Error, could not open " << filename << endl;
+    return 1;
+  }
+  TTree* settings = (TTree*) file->Get("settings");
+  TH1* hIncubationPeriod = (TH1*) file->Get("fhIncubationPeriod");
+  TH1* hInfectiousness   = (TH1*) file->Get("fhInfectiousness");
+  TH1* hLatentPeriod     = (TH1*) file->Get("fhLatentPeriod");
+  if(!settings || !hIncubationPeriod || !hInfectiousness || !hLatentPeriod) {
+    cout << "Error, " << filename << " has no settings tree or diagnostic histograms." << endl;
+    return 1;
+  }
+  //! the disease as set up in the simulation
+  int   index;
+  float symptomProbability, testPositiveProbability, falsePositiveRate, testThreshold;
+  float transmissionProbability, asymptomaticTransmissionScaling;
+  float incubationGamma, incubationMu, incubationBeta, infectionGamma, infectionMu, infectionBeta;
+  settings->SetBranchAddress("index",                  &index);
+  settings->SetBranchAddress("symptomProbability",     &symptomProbability);
+  settings->SetBranchAddress("testPositiveProbability",&testPositiveProbability);
+  settings->SetBranchAddress("falsePositiveRate",      &falsePositiveRate);
+  settings->SetBranchAddress("testThreshold",          &testThreshold);
+  settings->SetBranchAddress("transmissionProbability",&transmissionProbability);
+  settings->SetBranchAddress("AsymptomaticTransmissionScaling",&asymptomaticTransmissionScaling);
+  settings->SetBranchAddress("incubationGamma",&incubationGamma);
+  settings->SetBranchAddress("incubationMu",   &incubationMu);
+  settings->SetBranchAddress("incubationBeta", &incubationBeta);
+  settings->SetBranchAddress("infectionGamma", &infectionGamma);
+  settings->SetBranchAddress("infectionMu",    &infectionMu);
+  settings->SetBranchAddress("infectionBeta",  &infectionBeta);
+  Long64_t nRuns = settings->GetEntries();
+  Long64_t entry = 0;
+  for(settings->GetEntry(entry); gRun > -1 && index != gRun; settings->GetEntry(entry))
+    if(++entry == nRuns) {
+      cout << "Error, no run " << gRun << " in " << filename << endl;
+      return 1;
+    }
+  CVDisease disease;
+  disease.SetSymptomProbability(symptomProbability);
+  disease.SetTestPositiveProbability(testPositiveProbability);
+  disease.SetFalsePositiveRate(falsePositiveRate);
+  disease.SetTestThreshold(testThreshold);
+  disease.SetIncubationParameters(incubationGamma, incubationMu, incubationBeta);
+  disease.SetTransmissionProbability(transmissionProbability);
+  disease.SetAsymptomaticTransmissionScaling(asymptomaticTransmissionScaling);
+  disease.SetInfectiousnessParameters(infectionGamma, infectionMu, infectionBeta);
+  //! the histograms of all runs are summed in the file
+  hIncubationPeriod->Scale(1./nRuns);
+  hInfectiousness->Scale(1./nRuns);
+  hLatentPeriod->Scale(1./nRuns);
+
+  TCanvas* tc = CVDrawDiagnostics(&disease, hIncubationPeriod, hInfectiousness, hLatentPeriod);
+  if(gOutput.size() > 5 && gOutput.substr(gOutput.size()-5) == ".root") {
+    TFile output(gOutput.c_str(),"update");
+    tc->Write();
+    output.Close();
+  }
+  else tc->SaveAs(gOutput.c_str());
+  cout << "diagnostics of " << filename << " (" << nRuns << " runs) written to " << gOutput << endl;
+  delete tc;
+  file->Close();
+  return 0;
+}
+
+void Usage(const char* const exe)
+{
+   cout << "usage: " << exe << " [<options>] rootfile \n"
+    "\n"
+    " options:  -r (or --run):      disease settings of this run  (default: first run)\n"
+    "           -o (or --output):   pdf, png, .. or root file     (default: <rootfile>_diagnostic.pdf)\n"
+   << endl;
+}
+
+int GetOptions(int argc, char** argv)
+{
+   static struct option long_options[] = {
+     {"run",     required_argument, 0,'r'},
+     {"output",  required_argument, 0,'o'},
+     {"help",    no_argument,       0,'h'},
+     {0, 0, 0, 0}
+   };
+
+   int option_index = 0;
+   int c;
+   while ((c = getopt_long (argc, argv,
+    ":r:o:h",
+    long_options, &option_index)) != -1) {
+     switch (c) {
+       case 'r': gRun    = stoi(optarg); break;
+       case 'o': gOutput = optarg;       break;
+       case 'h': return -2;
+       default:  return -2;
+     }
+   }
+   return optind;
+}
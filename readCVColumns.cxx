@@ -0,0 +1,142 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Print runs and day ranges of the column file written by runCVMC -c as tsv, or list the
+ * runs it holds.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+
+//c++
+#include <iostream>
+#include <sstream>
+#include "getopt.h"
+
+#include "CVColumnFile.h"
+
+using namespace std;
+
+//! accessible via optarg
+int    gRun      =    -1; //! only this run (-1=all)
+int    gFirstDay =     0; //! only from this day ..
+int    gLastDay  = 99999; //! .. to this day
+string gSelect   =    ""; //! comma separated columns (empty=all)
+bool   gList     = false; //! list the runs and their number of days instead
+
+void Usage(const char* const exe);
+int  GetOptions(int argc, char** argv);
+
+int main(int argc, char** argv)
+{
+  //! get option input
+  const int nOptions = GetOptions(argc, argv);
+  if(nOptions < 0 || argc - nOptions < 1) {
+    Usage(argv[0]);
+    return 1;
+  };
+  CVColumnReader reader(argv[nOptions]);
+  if(!reader.IsOpen()) {
+    cout << "Error, " << argv[nOptions] << " is not a column file." << endl;
+    return 1;
+  }
+  if(gList) {
+    cout << "run\tnDays" << endl;
+    for(int irun = 0; irun < reader.GetNRuns(); irun++) cout << reader.GetRun(irun) << "\t" << reader.GetNRows(irun) << endl;
+    return 0;
+  }
+  //! columns to print
+  vector<int> columns;
+  if(gSelect == "") for(int icol = 0; icol < reader.GetNColumns(); icol++) columns.push_back(icol);
+  else {
+    stringstream select(gSelect);
+    string name;
+    while(getline(select,name,',')) {
+      int icol = reader.FindColumn(name);
+      if(icol < 0) {
+        cout << "Error, no column " << name << endl;
+        return 1;
+      }
+      columns.push_back(icol);
+  } }
+  for(size_t icol = 0; icol < columns.size(); icol++) cout << (icol ? "\t" : "") << reader.GetColumnName(columns[icol]);
+  cout << endl;
+  //! runs to print
+  vector<int> runs;
+  if(gRun < 0) for(int irun = 0; irun < reader.GetNRuns(); irun++) runs.push_back(irun);
+  else if(reader.FindRun(gRun) > -1) runs.push_back(reader.FindRun(gRun));
+  else {
+    cout << "Error, no run " << gRun << endl;
+    return 1;
+  }
+  for(auto irun : runs) {
+    pair<int,int> rows = reader.GetDayRange(irun,gFirstDay,gLastDay);
+    for(int irow = rows.first; irow < rows.second; irow++) {
+      for(size_t icol = 0; icol < columns.size(); icol++) {
+        if(icol) cout << "\t";
+        if(reader.GetColumnType(columns[icol]) == C_Float32) cout << reader.GetFloat(irun,columns[icol])[irow];
+        else                                                 cout << reader.GetInt(irun,columns[icol])[irow];
+      }
+      cout << endl;
+  } }
+  return 0;
+}
+
+void Usage(const char* const exe)
+{
+   cout << "usage: " << exe << " [<options>] columnfile \n"
+    "\n"
+    " options:  -r (or --run):      only this run                 (default: all)\n"
+    "           -f (or --first):    first day                     (default: " << gFirstDay << ")\n"
+    "           -l (or --last):     last day                      (default: " << gLastDay  << ")\n"
+    "           -s (or --select):   comma separated columns       (default: all)\n"
+    "           -L (or --list):     list the runs and their days \n"
+   << endl;
+}
+
+int GetOptions(int argc, char** argv)
+{
+   static struct option long_options[] = {
+     {"run",     required_argument, 0,'r'},
+     {"first",   required_argument, 0,'f'},
+     {"last",    required_argument, 0,'l'},
+     {"select",  required_argument, 0,'s'},
+     {"list",    no_argument,       0,'L'},
+     {"help",    no_argument,       0,'h'},
+     {0, 0, 0, 0}
+   };
+
+   int option_index = 0;
+   int c;
+   while ((c = getopt_long (argc, argv,
+    ":r:f:l:s:Lh",
+    long_options, &option_index)) != -1) {
+     switch (c) {
+       case 'r': gRun      = stoi(optarg); break;
+       case 'f': gFirstDay = stoi(optarg); break;
+       case 'l': gLastDay  = stoi(optarg); break;
+       case 's': gSelect   = optarg;       break;
+       case 'L': gList     = true;         break;
+       case 'h': return -2;
+       default:  return -2;
+     }
+   }
+   return optind;
+}
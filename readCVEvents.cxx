@@ -0,0 +1,172 @@
+/*
+Copyright 2020 ContacTUM
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+the Software is furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Decode and filter the binary event record written by runCVMC -e.
+ *
+ * @author Tina Pollmann, Christoph Wiesinger
+ * @date 2020
+ */
+
+
+//c++
+#include <iostream>
+#include <map>
+#include "getopt.h"
+
+#include "CVEventLog.h"
+
+using namespace std;
+
+//! accessible via optarg
+int  gRun      =    -1; //! only this run (-1=all)
+int  gType     =    -1; //! only this event type (-1=all)
+int  gPerson   =    -1; //! only events involving this person (-1=all)
+int  gFirstDay =     0; //! only from this day ..
+int  gLastDay  = 99999; //! .. to this day
+bool gCount    = false; //! print counts per run and type instead of the events
+
+static const char* const kReasonNames[Reason_COUNT] = { "symptoms", "traced", "retest", "random", "contact" };
+
+void Usage(const char* const exe);
+int  GetOptions(int argc, char** argv);
+void PrintEvent(const CVEvent& event);
+
+int main(int argc, char** argv)
+{
+  //! get option input
+  const int nOptions = GetOptions(argc, argv);
+  if(nOptions < 0 || argc - nOptions < 1) {
+    Usage(argv[0]);
+    return 1;
+  };
+  //! open the file and check the header
+  ifstream input(argv[nOptions], ios::binary);
+  int32_t header[4];
+  if(!input.read((char*) header, sizeof(header)) || header[0] != CVEventFile::kMagic) {
+    cout << "Error, " << argv[nOptions] << " is not an event file." << endl;
+    return 1;
+  }
+  if(header[1] != CVEventFile::kVersion || header[2] != (int32_t) sizeof(CVEvent)) {
+    cout << "Error, event file version " << header[1] << " with record size " << header[2] << " is not supported." << endl;
+    return 1;
+  }
+  //! loop over the records in blocks
+  map<int, vector<long> > counts; //! run -> number of events per type
+  vector<CVEvent> events(8192);
+  while(input) {
+    input.read((char*) &events[0], events.size()*sizeof(CVEvent));
+    size_t nEvents = input.gcount()/sizeof(CVEvent);
+    for(size_t ievent = 0; ievent < nEvents; ievent++) {
+      const CVEvent& event = events[ievent];
+      if(gRun  > -1 && event.run  != gRun ) continue;
+      if(gType > -1 && event.type != gType) continue;
+      if(event.day < gFirstDay || event.day > gLastDay) continue;
+      //! exposures and traces also involve the person in value
+      if(gPerson > -1 && event.person != gPerson &&
+         !((event.type == E_Exposure || event.type == E_Trace) && event.value == gPerson)) continue;
+      if(gCount) {
+        vector<long>& count = counts[event.run];
+        count.resize(Event_COUNT,0);
+        if(event.type < Event_COUNT) count[event.type]++;
+      }
+      else PrintEvent(event);
+  } }
+  if(gCount) {
+    cout << "run";
+    for(int itype = 0; itype < Event_COUNT; itype++) cout << "\t" << kCVEventNames[itype];
+    cout << endl;
+    for(auto kv : counts) {
+      cout << kv.first;
+      for(auto count : kv.second) cout << "\t" << count;
+      cout << endl;
+  } }
+  return 0;
+}
+
+void PrintEvent(const CVEvent& event)
+{
+  cout << "run " << event.run << "\tday " << event.day << "\t";
+  if(event.type >= Event_COUNT) { cout << "unknown event type " << int(event.type) << endl; return; }
+  cout << kCVEventNames[event.type] << "\tperson " << event.person;
+  const char* reason = event.detail < Reason_COUNT ? kReasonNames[event.detail] : "?";
+  switch(event.type) {
+    case E_Exposure:   cout << " by " << event.value; break;
+    case E_Report:     cout << " on day " << event.value << " (" << reason << ")"; break;
+    case E_Test:       cout << (event.value ? " positive" : " negative") << " (" << reason << ")"; break;
+    case E_Trace:
+      cout << " from " << event.value;
+      if      (event.detail == 98) cout << " missed";
+      else if (event.detail == 99) cout << " too far back";
+      else                         cout << " order " << int(event.detail);
+      break;
+    case E_Quarantine: cout << " for " << event.value << " days (" << reason << ")"; break;
+    case E_Release:    cout << " removed " << event.value << " days"; break;
+    default: /*do nothing*/ break;
+  }
+  cout << endl;
+}
+
+void Usage(const char* const exe)
+{
+   cout << "usage: " << exe << " [<options>] eventfile \n"
+    "\n"
+    " options:  -r (or --run):      only this run                 (default: all)\n"
+    "           -t (or --type):     only this event type          (exposure, report, test, trace, quarantine, release)\n"
+    "           -p (or --person):   only events involving person  (default: all)\n"
+    "           -f (or --first):    first day                     (default: " << gFirstDay << ")\n"
+    "           -l (or --last):     last day                      (default: " << gLastDay  << ")\n"
+    "           -c (or --count):    count events per run and type \n"
+   << endl;
+}
+
+int GetOptions(int argc, char** argv)
+{
+   static struct option long_options[] = {
+     {"run",     required_argument, 0,'r'},
+     {"type",    required_argument, 0,'t'},
+     {"person",  required_argument, 0,'p'},
+     {"first",   required_argument, 0,'f'},
+     {"last",    required_argument, 0,'l'},
+     {"count",   no_argument,       0,'c'},
+     {"help",    no_argument,       0,'h'},
+     {0, 0, 0, 0}
+   };
+
+   int option_index = 0;
+   int c;
+   while ((c = getopt_long (argc, argv,
+    ":r:t:p:f:l:ch",
+    long_options, &option_index)) != -1) {
+     switch (c) {
+       case 'r': gRun      = stoi(optarg); break;
+       case 't':
+         for(int itype = 0; itype < Event_COUNT; itype++)
+           if(string(optarg) == kCVEventNames[itype]) gType = itype;
+         if(gType < 0) return -2;
+         break;
+       case 'p': gPerson   = stoi(optarg); break;
+       case 'f': gFirstDay = stoi(optarg); break;
+       case 'l': gLastDay  = stoi(optarg); break;
+       case 'c': gCount    = true;         break;
+       case 'h': return -2;
+       default:  return -2;
+     }
+   }
+   return optind;
+}
@@ -26,23 +26,39 @@ DEALINGS IN THE SOFTWARE.
 
 //c++
 #include "getopt.h"
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <set>
 
 //external (included in project)
 #include "json.hpp"
 
-//root
-#include "TSystem.h"
-
 #include "CVMC.h"
+#include "CVSweep.h"
 
 using namespace std;
 
 //! accessible via optarg
 bool   gDebugMode      = false;
+bool   gTiming         = false; //! per-phase timing of each day
+bool   gHeadless       = false; //! no canvases (draw them with plotCVMC)
+int    gHashBlocks     =    -1; //! blocks of persons in the daily state hash (-1=off, 0=whole population only)
 int    gMaxPeopleInDot =   400;
 int    gNSimulations   =     1; //! times
 int    gIndex          =     0; //! start index for output
+int    gThreads        =     1; //! runs simulated at the same time
 int    gRandomSeed     =     0; //! random seed (0=random)
+bool   gCommonRandom   = false; //! common random numbers: replicate i of every point has the same seed and world
+bool   gFork           = false; //! simulate the days before the interventions once per replicate for all points
+string gEventFilename  =    ""; //! binary event record (empty=off, <prefix>_events.cvev in debug mode)
+string gColumnFilename =    ""; //! daily census as column file (empty=off)
+string gSummaryFilename =   ""; //! only a json line per run to this file instead of root output (empty=off, -=std out)
+string gBandsFilename  =    ""; //! ensemble bands of the daily census over all runs (empty=off)
+string gCheckpointFilename = ""; //! checkpoint of the job (empty=off)
+int    gCheckpointDays =    50; //! days between checkpoints
+bool   gResume         = false; //! continue the job from its checkpoint
 
 //! accessible via json 
 string gOutputPrefix     =  "CovidMCResult";
@@ -86,23 +102,242 @@ float  gInfectionBeta           =  1.56;  //!
 
 void Usage(const char* const exe);
 int  GetOptions(int argc, char** argv);
-void ParseJSON(string);
+void ParseJSON(const nlohmann::json&);
+CVMC* MakeSimulation();
+void Configure(CVMC* sim);
 
 int main(int argc, char** argv)
 {
   //! get option input
   const int nOptions = GetOptions(argc, argv);
-  if(nOptions < 0 || argc - nOptions < 1) {
+  if(nOptions < 0 || argc - nOptions < 1 || gThreads < 1) {
     Usage(argv[0]);
     return 1;
   };
+  //! root is used by several threads: the workers, and the thread that writes the root output
+  if(gThreads > 1 || gSummaryFilename == "") ROOT::EnableThreadSafety();
   //! get json input
-  string input_filename(argv[nOptions]);
-  ParseJSON(input_filename.c_str());
+  //! with --summary-only -, std out only gets the summaries, everything else goes to std err
+  int summaryFd = -1;
+  if(gSummaryFilename == "-") {
+    fflush(stdout);
+    summaryFd = dup(1);
+    dup2(2,1);
+  }
+  using json = nlohmann::json;
+  json input;
+  ifstream inputFile(argv[nOptions]);
+  if(!inputFile.good()) {
+    cout << "Error, could not open " << argv[nOptions] << endl;
+    return 1;
+  }
+  inputFile >> input;
+  //! ... with the points of the parameter sweep in it
+  CVSweep sweep(input);
+  if(!sweep.IsValid()) {
+    cout << "Error, " << sweep.GetError() << endl;
+    return 1;
+  }
+  const int nPoints = sweep.GetNPoints();
+  for(int ipoint = 0; ipoint < nPoints && nPoints > 1; ipoint++) cout << "Point " << ipoint << ": " << sweep.Describe(ipoint) << endl;
+  //! the bands are taken over all runs, which would mix the points
+  if(nPoints > 1 && gBandsFilename != "") {
+    cout << "Error, the bands (-b) can not be written for a sweep of " << nPoints << " points" << endl;
+    return 1;
+  }
+  ParseJSON(sweep.GetPoint(0));
+  //! the points can only share the days before the interventions if they differ in nothing else
+  if(gFork) {
+    //! the parameters that are only used once the interventions started
+    const set<string> interventionParameters = { "SocialDistancingMaxPeople", "SocialDistancingFrom", "SocialDistancingTo", 
+      "SocialDistancingFactor", "TracingOrder", "DaysBackwardTrace", "BackwardTracing", "TraceUninfected", "AppProbability", 
+      "tracingEfficiency", "TracingDelay", "DaysToTestResult", "dTTest", "RandomTesting", "RandomTestingRate" };
+    for(int ipoint = 1; ipoint < nPoints; ipoint++) {
+      for(auto& change : json::diff(sweep.GetPoint(0),sweep.GetPoint(ipoint))) {
+        const string path = change["path"];
+        const string parameter = path.substr(1,path.find('/',1)-1);
+        if(interventionParameters.count(parameter)) continue;
+        cout << "Error, with --fork only parameters of the interventions can be swept, not " << parameter << endl;
+        return 1;
+    } }
+    if(gDebugMode) {
+      cout << "Error, --fork can not be used in debug mode" << endl;
+      return 1;
+  } }
+  //! checkpoints are written by a job that simulates one run at a time; the job is identified
+  //! by its input and the options that change its runs and output
+  uint64_t job = 0;
+  CVCheckpointHeader checkpoint = {};
+  int firstRun = 0;
+  if(gResume && gCheckpointFilename == "") {
+    cout << "Error, --resume needs the checkpoint file (-k)" << endl;
+    return 1;
+  }
+  if(gCheckpointFilename != "") {
+    if(gThreads > 1 || gFork || gDebugMode || gCheckpointDays < 1) {
+      cout << "Error, checkpoints are only written with -j 1, without --fork and debug mode, and at most every day" << endl;
+      return 1;
+    }
+    //! the root output, column file and bands are written from the start, so they can only be
+    //! continued in the run they were started in
+    if(gNSimulations*nPoints > 1 && (gSummaryFilename == "" || gBandsFilename != "")) {
+      cout << "Error, checkpoints of jobs with several runs are only written with --summary-only and without bands" << endl;
+      return 1;
+    }
+    for(char ch : input.dump()) job = CVHashCombine(job, uint8_t(ch));
+    int options[] = { gNSimulations, gIndex, gRandomSeed, gCommonRandom, gHashBlocks, gEventFilename != "" || gDebugMode, gSummaryFilename != "" };
+    for(int option : options) job = CVHashCombine(job, uint32_t(option));
+  }
+  //! ... continuing with the run of the checkpoint, or the next one if it was finished
+  if(gResume) {
+    CVCheckpointReader reader(gCheckpointFilename);
+    if(!reader.IsGood()) {
+      cout << "Error, " << reader.GetError() << endl;
+      return 1;
+    }
+    checkpoint = reader.GetHeader();
+    if(checkpoint.job != job) {
+      cout << "Error, " << gCheckpointFilename << " was written by a job with other input or options" << endl;
+      return 1;
+    }
+    firstRun = checkpoint.run - gIndex + (checkpoint.day < 0);
+    cout << "Resuming with run " << gIndex + firstRun << (checkpoint.day > -1 ? Form(" on day %d",checkpoint.day) : "") << endl;
+    if(firstRun > 0 && (gSummaryFilename == "" || gBandsFilename != "")) {
+      cout << "Error, the run of " << gCheckpointFilename << " is finished, its root output and bands can not be continued" << endl;
+      return 1;
+    }
+  }
 
-  //! initialize and set
+  //! ... event recording
+  if(gEventFilename == "" && gDebugMode) gEventFilename = gOutputPrefix + "_events.cvev";
+  CVEventFile* eventFile = 0;
+  if(gEventFilename != "") {
+    //! .. up to the checkpoint if resumed
+    eventFile = gResume ? new CVEventFile(gEventFilename,checkpoint.eventOffset) : new CVEventFile(gEventFilename);
+    if(!eventFile->IsOpen()) {
+      cout << "Error, could not open event file " << gEventFilename << endl;
+      delete eventFile;
+      eventFile = 0;
+    }
+  }
+  //! ... either only the summary of every run ..
+  CVOutput* output = 0;
+  ofstream* summaryOutput = 0;
+  if(gSummaryFilename != "") {
+    if(summaryFd > -1) summaryOutput = new ofstream(Form("/dev/fd/%d",summaryFd), ios::app);
+    else if(gResume && truncate(gSummaryFilename.c_str(),checkpoint.summaryOffset) == 0) 
+                       summaryOutput = new ofstream(gSummaryFilename.c_str(), ios::app | ios::ate);
+    else               summaryOutput = new ofstream(gSummaryFilename.c_str());
+    if(!summaryOutput->is_open() || (gResume && summaryFd < 0 && summaryOutput->tellp() != checkpoint.summaryOffset)) {
+      cout << "Error, could not open summary file " << gSummaryFilename << endl;
+      return 1;
+    }
+    if(gColumnFilename != "") cout << "Warning, no column file is written with --summary-only" << endl;
+  }
+  //! ... or all runs to one file, Sum_<prefix>.root if more than one simulation is run
+  else {
+    string outputFilename = gNSimulations*nPoints > 1 ? Form("Sum_%s.root",gOutputPrefix.c_str()) : Form("%s_%d.root",gOutputPrefix.c_str(),gIndex);
+    output = new CVOutput(outputFilename);
+    if(!output->IsOpen()) {
+      cout << "Error, could not open output file " << outputFilename << endl;
+      return 1;
+    }
+    if(gColumnFilename != "" && !output->SetColumnFile(gColumnFilename)) 
+      cout << "Error, could not open column file " << gColumnFilename << endl;
+  }
+  //! ... with the bands over all runs ..
+  CVEnsembleBands* bands = gBandsFilename != "" ? new CVEnsembleBands() : 0;
+  //! ... and with common random numbers, one seed per replicate for all points
+  vector<int> seeds(gNSimulations, gRandomSeed);
+  if(gCommonRandom) {
+    const uint64_t base = gRandomSeed ? gRandomSeed : TRandom3(0).GetSeed();
+    for(int irep = 0; irep < gNSimulations; irep++) seeds[irep] = CVHashCombine(base, irep) % 2147483646 + 1;
+  }
+
+  //! ... and run all replicates of all points; each worker takes the next run when it is done,
+  //! with its own simulation, which is set up again when the next run is of another point
+  atomic<int> next(firstRun);
+  bool resumed = true; //! false if the run of the checkpoint could not be continued
+  mutex settingsMutex; //! guards the parameters, which are set from the point, and the bands
+  auto Work = [&]() {
+    TDirectory::TContext context(0); //! the objects of the simulation belong to no directory
+    CVMC* sim = 0;
+    int simPoint = -1;
+    CVEnsembleBands workerBands;
+    auto SetPoint = [&](int ipoint) {
+      if(ipoint == simPoint) return;
+      lock_guard<mutex> lock(settingsMutex);
+      ParseJSON(sweep.GetPoint(ipoint));
+      if(!sim || sim->GetNPersons() != gNPersons || sim->GetNDays() != gNDays) {
+        delete sim;
+        sim = MakeSimulation();
+        if(eventFile)     sim->SetEventFile(eventFile);
+        if(output)        sim->SetOutput(output);
+        if(summaryOutput) sim->SetSummaryOutput(summaryOutput);
+        if(bands)         sim->SetBands(&workerBands);
+        if(gCheckpointFilename != "") sim->SetCheckpoint(gCheckpointFilename,gCheckpointDays,job);
+        sim->SetCommonRandomNumbers(gCommonRandom);
+      }
+      Configure(sim);
+      sim->SetPoint(ipoint);
+      simPoint = ipoint;
+    };
+    //! with --fork, the workers take replicates and run all points of them, as the same runs
+    if(gFork) {
+      for(int irep = next++; irep < gNSimulations; irep = next++) {
+        SetPoint(0);
+        sim->RunVariants(gIndex+irep,seeds[irep],nPoints,gNSimulations,SetPoint);
+    } }
+    else for(int irun = next++; irun < gNSimulations*nPoints; irun = next++) {
+      SetPoint(irun/gNSimulations);
+      if(gResume && irun == firstRun && checkpoint.day > -1) {
+        if(!(resumed = sim->Resume(gCheckpointFilename))) break;
+      }
+      else sim->Run(gIndex+irun,seeds[irun%gNSimulations]);
+    }
+    delete sim;
+    lock_guard<mutex> lock(settingsMutex);
+    if(bands) bands->Merge(workerBands);
+  };
+  vector<thread> workers;
+  for(int ithread = 1; ithread < gThreads; ithread++) workers.push_back(thread(Work));
+  Work();
+  for(auto& worker : workers) worker.join();
+
+  if(bands) {
+    TFile bandsFile(gBandsFilename.c_str(),"RECREATE");
+    if(bandsFile.IsZombie()) cout << "Error, could not open bands file " << gBandsFilename << endl;
+    else {
+      bands->MakeTree()->Write();
+      bandsFile.Close();
+    }
+  }
+  delete output;
+  delete summaryOutput;
+  delete eventFile;
+  delete bands;
+  //! the job is done, there is nothing to resume
+  if(!resumed) return 1;
+  if(gCheckpointFilename != "") remove(gCheckpointFilename.c_str());
+  return 0;
+}
+
+//! a simulation with the current parameters and the options of the job
+CVMC* MakeSimulation()
+{
   CVMC* sim = new CVMC(gNPersons,gNDays,gAppProbability,gReportingProbability,gOutputPrefix);
   if(gDebugMode) sim->SetDebug();
+  if(gTiming)    sim->SetTiming();
+  if(gHeadless)  sim->SetHeadless();
+  if(gHashBlocks > -1) sim->SetStateHashing(gHashBlocks);
+  return sim;
+}
+
+//! set the current parameters in a simulation
+void Configure(CVMC* sim)
+{
+  sim->SetAppProbability(gAppProbability);
+  sim->SetReportingProbability(gReportingProbability);
   //! ... general settings
   sim->SetPeopleMetPerDay(gPeopleMetPerDay);
   sim->SetDaysInQuarantine(gDaysInQuarantine);
@@ -133,19 +368,6 @@ int main(int argc, char** argv)
   sim->GetDisease()->SetAsymptomaticTransmissionScaling(gAsymptomaticTransmissionScaling); 
   sim->GetDisease()->SetInfectiousnessParameters(gInfectionGamma,gInfectionMu,gInfectionBeta);
   sim->GetDisease()->SetTestThreshold(gTestThreshold);
-  //! ... and run it repeatedly
-  for(int irun=gIndex;irun<gIndex+gNSimulations;irun++)
-    sim->Run(irun,gRandomSeed);
-
-  delete sim;
-  //! Add all the output files together if more than one simulation was run, and then delete the individual files.
-  if (gNSimulations > 1) {
-    string filenames = Form("%s_*.root",gOutputPrefix.c_str());
-    string filenamesum = Form("Sum_%s.root",gOutputPrefix.c_str());
-    gSystem->Exec(Form("hadd -f %s %s",filenamesum.c_str(),filenames.c_str()));
-    gSystem->Exec(Form("rm %s",filenames.c_str()));  
-  }
-  return 0;
 }
 
 void Usage(const char* const exe)
@@ -155,9 +377,30 @@ void Usage(const char* const exe)
     " options:  "/*-o (or --output):   output prefix                 (default: " << gOutputPrefix   << ")\n" 
     "        */"-n (or --nsim):     simulation number             (default: " << gNSimulations   << ")\n"     
     "           -i (or --index):    start index                   (default: " << gIndex          << ")\n"    
+    "           -j (or --threads):  runs simulated at the same time (default: " << gThreads      << ")\n"    
     "           -s (or --seed):     random number seed            (default: " << gRandomSeed     << ")\n"  
+    "           -r (or --crn):      common random numbers: the replicates of all points of a \n"
+    "                               sweep have the same seeds, contacts and disease courses \n"
+    "           -f (or --fork):     simulate the days before the interventions start once per \n"
+    "                               replicate and continue all points of the sweep from there \n"
     "           -d (or --debug):    run with increased verbostiy \n" 
     "           -m (or --maxdots):  maximum people in dotfile     (default: " << gMaxPeopleInDot << ")\n"  
+    "           -e (or --events):   record events to binary file  (read with readCVEvents) \n"  
+    "           -c (or --columns):  write the daily census to a   (read with readCVColumns or CVColumns.py) \n"  
+    "                               root-independent column file \n"  
+    "           -S (or --summary-only): write only a json line    (- for std out) \n"  
+    "                               per run to this file, no root output \n"  
+    "           -b (or --bands):    write the mean, rms and 5/50/95% quantiles of the daily census \n"  
+    "                               over all runs to this root file (EnsembleBands tree, not for sweeps) \n"  
+    "           -g (or --headless): no graphics objects           (draw the diagnostics with plotCVMC) \n"  
+    "           -t (or --timing):   time the phases of each day   (PerformanceInformation tree) \n"  
+    "           -H (or --hash):     hash the state each day with  (StateHash tree, compare with bisectCVMC) \n"  
+    "                               this many blocks of persons \n"  
+    "           -k (or --checkpoint): write a checkpoint of the job to this file (only with -j 1, \n"  
+    "                               and with -S and without -b for several runs) \n"  
+    "           -K (or --checkpoint-days): days between checkpoints (default: " << gCheckpointDays << ")\n"  
+    "           -R (or --resume):   continue the job from its checkpoint (-k), with the same \n"  
+    "                               input and options \n"  
    << endl;
 }
 
@@ -166,9 +409,22 @@ int GetOptions(int argc, char** argv)
    static struct option long_options[] = {
      {"nsim",    required_argument, 0,'n'}, 
      {"index",   required_argument, 0,'i'}, 
+     {"threads", required_argument, 0,'j'}, 
      {"seed",    required_argument, 0,'s'}, 
+     {"crn",     no_argument,       0,'r'},  
+     {"fork",    no_argument,       0,'f'},  
      {"debug",   no_argument,       0,'d'},  
      {"maxdots", required_argument, 0,'m'},         
+     {"events",  required_argument, 0,'e'},         
+     {"columns", required_argument, 0,'c'},         
+     {"summary-only",required_argument,0,'S'},         
+     {"bands",   required_argument, 0,'b'},         
+     {"headless",no_argument,       0,'g'},         
+     {"timing",  no_argument,       0,'t'},         
+     {"hash",    required_argument, 0,'H'},         
+     {"checkpoint",required_argument,0,'k'},         
+     {"checkpoint-days",required_argument,0,'K'},         
+     {"resume",  no_argument,       0,'R'},         
      {"help",    no_argument,       0,'h'},
      {0, 0, 0, 0}
    };
@@ -176,14 +432,27 @@ int GetOptions(int argc, char** argv)
    int option_index = 0;
    int c;
    while ((c = getopt_long (argc, argv,
-    ":n:i:s:dm:h",
+    ":n:i:j:s:rfdm:e:c:S:b:gtH:k:K:Rh",
     long_options, &option_index)) != -1) {
      switch (c) {
        case 'n': gNSimulations   = stoi(optarg); break;       
        case 'i': gIndex          = stoi(optarg); break; 
+       case 'j': gThreads        = stoi(optarg); break; 
        case 's': gRandomSeed     = stoi(optarg); break;      
+       case 'r': gCommonRandom   = true;         break;
+       case 'f': gFork           = true;         break;
        case 'd': gDebugMode      = true;         break;
        case 'm': gMaxPeopleInDot = stoi(optarg); break;     
+       case 'e': gEventFilename  = optarg;       break;     
+       case 'c': gColumnFilename = optarg;       break;     
+       case 'S': gSummaryFilename = optarg;      break;     
+       case 'b': gBandsFilename  = optarg;       break;     
+       case 'g': gHeadless       = true;         break;
+       case 't': gTiming         = true;         break;
+       case 'H': gHashBlocks     = stoi(optarg); break;
+       case 'k': gCheckpointFilename = optarg;   break;
+       case 'K': gCheckpointDays = stoi(optarg); break;
+       case 'R': gResume         = true;         break;
        case 'h': return -2;
        default:  return -2;
      }
@@ -191,12 +460,8 @@ int GetOptions(int argc, char** argv)
    return optind;
 }
 
-void ParseJSON(std::string inputfile)
+void ParseJSON(const nlohmann::json& j)
 {
-  using json = nlohmann::json;
-  std::ifstream i(inputfile.c_str());
-  json j;
-  i >> j;
 
   //! general
   gOutputPrefix     = j["OutputPrefix"];